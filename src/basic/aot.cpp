@@ -0,0 +1,728 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include <iostream>
+#include <cstring>
+#include <cmath>
+#include <limits>
+#include "aot.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace a= czlab::aeon;
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Aot::main(void (*run)()){
+  try{
+    run();
+  }catch(const a::Error& e){
+    std::cout << e.what() << "\n";
+  }catch(...){
+    std::cout << "Error!!!" << "\n";
+  }
+  return 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Aot::write(cstdstr& s){ std::cout << s; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Aot::print(const Value& v){
+  if(v) std::cout << v.pr_str(0);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Aot::writeln(){ std::cout << "\n"; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Aot::input(cstdstr& vn){
+  stdstr s;
+  std::getline(std::cin,s);
+  auto cs= s.c_str();
+  Value v;
+  if(vn[vn.size()-1]=='$')
+    v= Value::make(s);
+  else
+  if(::strchr(cs, '.'))
+    v= Value::make(::atof(cs));
+  else
+    v= Value::make(::atoi(cs));
+  return checked(vn,v);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Aot::read(d::Addr _A){
+  if(!s__index(dataPtr,data) || !data[dataPtr])
+    E_SEMANTIC("Can't read data near %s", d::pr_addr(_A).c_str());
+  return data[dataPtr++];
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Aot::unary(int op, const Value& v, d::Addr _A){
+  auto& n = vnum(v,_A);
+  if(op != d::T_MINUS)
+    return v;
+  return n.isInt() ? Value::make(- n.getInt()) : Value::make(- n.getFloat());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Aot::negate(const Value& v, d::Addr _A){
+  return Value::make(vnum(v,_A).isZero() ? 1 : 0);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Aot::bind(cstdstr& vn, Value& slot, const Value& v){
+  ensure_data_type(vn, v);
+  auto o= slot;
+  slot= v;
+  return o;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Aot::get(const Value& f, const ValueVec& args, cstdstr& vn, d::Addr _A){
+  if(!f)
+    RAISE(d::NoSuchVar, "Unknown function/array: %s", vn.c_str());
+  auto fa= vcast<BArray>(f);
+  if(E_NIL(fa))
+    expected("Array var or function", f.box(), _A);
+  return fa->get(ValSlice(args));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Aot::call(Invoker fn, const Value& f,
+                 const ValueVec& args, cstdstr& vn, d::Addr _A){
+  return E_NIL(vcast<LibFunc>(f))
+         ? get(f,args,vn,_A) : fn(P_NIL, ValSlice(args));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Aot::set(const Value& f, const ValueVec& args,
+              cstdstr& vn, const Value& v, d::Addr _A){
+  auto arr= vcast<BArray>(f,_A);
+  ensure_data_type(vn,v);
+  arr->set(ValSlice(args), v);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Aot::forBegin(ForLoopInfo& f,
+                   const Value& term, const Value& step, d::Addr _A){
+  f.term= term;
+  f.step= step;
+  vnum(f.step,_A);
+  vnum(f.term,_A);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static bool for_done(ForLoopInfo& f, double z){
+  bool quit=1;
+  if(f.step.isPos())
+    quit = z > f.term.getFloat();
+  if(f.step.isNeg())
+    quit = z < f.term.getFloat();
+  if(quit)
+    f.init=Value();
+  return quit;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Aot::forInit(ForLoopInfo& f, Value& v, const Value& init, d::Addr _A){
+  f.init= init;
+  auto z= vnum(f.init,_A).getFloat();
+  v= checked(f.var, f.init);
+  f.ints= f.init.isInt() && f.term.isInt() && f.step.isInt();
+  return for_done(f,z);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Aot::forNext(ForLoopInfo& f, Value& v, d::Addr _A){
+  if(f.ints && v.isInt()){
+    auto i= v.getInt() + f.step.getInt();
+    bool quit=1;
+    v= Value::make(i);
+    if(f.step.isPos())
+      quit = i > f.term.getInt();
+    if(f.step.isNeg())
+      quit = i < f.term.getInt();
+    if(quit)
+      f.init=Value();
+    return quit;
+  }
+  vnum(v,_A);
+  auto z = v.getFloat() + f.step.getFloat();
+  v= checked(f.var, v.isInt() ? Value::make((llong) z) : Value::make(z));
+  return for_done(f,z);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Aot::ret(){
+  if(returns.empty())
+    RAISE(d::BadArg, "Bad gosub-return: %s", "no sub called");
+  auto r= returns.back();
+  returns.pop_back();
+  return r;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Aot::bad(int line, bool sub){
+  if(sub)
+    RAISE(d::BadArg, "Bad gosub<%d>", line);
+  RAISE(d::BadArg, "Bad goto<%d>", line);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static stdstr quote(cstdstr& s){
+  stdstr buf {"\""};
+  for(auto c : s){
+    auto u= (unsigned char) c;
+    if(c == '"' || c == '\\'){
+      buf += '\\'; buf += c; }
+    else
+    if(u < 32 || u > 126){
+      // octal never runs into the next char.
+      Tchar oct[8];
+      ::snprintf(oct, sizeof(oct), "\\%03o", u);
+      buf += oct; }
+    else
+      buf += c; }
+  return buf + "\"";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static stdstr literal(const Value& v){
+  if(v.isInt()){
+    auto n= v.getInt();
+    if(n == std::numeric_limits<llong>::min())
+      return "Value::make(std::numeric_limits<llong>::min())";
+    return "Value::make((llong) " + N_STR(n) + ")";
+  }
+  if(v.tag == V_REAL){
+    auto r= v.getFloat();
+    if(std::isnan(r))
+      return "Value::make(std::nan(\"\"))";
+    if(std::isinf(r))
+      return stdstr("Value::make(") +
+             (r < 0 ? "-" : "") + "std::numeric_limits<double>::infinity())";
+    // hex floats round trip exactly.
+    Tchar buf[64];
+    ::snprintf(buf, sizeof(buf), "%a", r);
+    return stdstr("Value::make(") + buf + ")";
+  }
+  return "Value::make(stdstr(" + quote(vcast<d::String>(v)->impl()) + "))";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Emitter::emit(d::DAst tree, std::ostream& os){
+  body.clear();
+  DCAST(Ast,tree)->cpp(this);
+  auto n= vm->slotCount();
+
+  os << "// generated by ubasic --emit-cpp, do not edit.\n";
+  os << "#include <cmath>\n";
+  os << "#include <limits>\n";
+  os << "#include \"basic/aot.h\"\n";
+  os << "#if defined(__GNUC__)\n";
+  os << "#pragma GCC diagnostic ignored \"-Wunused-label\"\n";
+  os << "#pragma GCC diagnostic ignored \"-Wunused-variable\"\n";
+  os << "#endif\n\n";
+  os << "namespace czlab::basic{\n";
+  os << "namespace d= czlab::dsl;\n\n";
+  os << "static Aot rt;\n";
+  os << "static Value S[" << std::max(n,1) << "];\n";
+  for(auto i=0; i < n; ++i)
+    os << "// S[" << i << "] " << vm->slotName(i) << "\n";
+  if(!consts.empty())
+    os << "static Value K[" << consts.size() << "];\n";
+  for(auto i=0; i < (int) loops.size(); ++i)
+    os << "static DslFLInfo F" << i << ";\n";
+  os << "\n";
+
+  for(auto& [s,a] : arity){
+    stdstr pms;
+    for(auto i=0; i < a; ++i)
+      pms += stdstr(i > 0 ? ", " : "") + "const Value&";
+    os << "static Value FN" << s << "(" << pms << ");\n"; }
+  for(auto& [s,f] : fns)
+    os << "\n" << f;
+
+  os << "\nstatic void run(){\n";
+  os << "  int line=0;\n";
+  os << "  bool sub=0;\n";
+  for(auto i=0; i < (int) consts.size(); ++i)
+    os << "  K[" << i << "]= " << consts[i] << ";\n";
+  for(auto i=0; i < (int) loops.size(); ++i)
+    os << "  F" << i << "= " << loops[i] << ";\n";
+  for(auto i=0; i < n; ++i)
+    if(auto f= native_name(vm->slotName(i)); !f.empty())
+      os << "  S[" << i << "]= Value::make(LibFunc::make("
+         << quote(vm->slotName(i)) << ", &" << f << "));\n";
+  if(!items.empty()){
+    os << "  rt.data= ValueVec{\n";
+    for(auto i=0; i < (int) items.size(); ++i)
+      os << "    " << items[i] << (i+1 < (int) items.size() ? ",\n" : "\n");
+    os << "  };\n"; }
+
+  os << body;
+  os << label(lineNums.size(), 0) << ":\n";
+  os << "  return;\n";
+
+  // computed GOTO and GOSUB.
+  os << "jump:\n";
+  os << "  switch(line){\n";
+  for(auto i=0; i < (int) lineNums.size(); ++i)
+    os << "  case " << lineNums[i] << ": goto " << label(i,0) << ";\n";
+  os << "  }\n";
+  os << "  rt.bad(line, sub);\n";
+  os << "  return;\n";
+
+  os << "ret:\n";
+  os << "  switch(rt.ret()){\n";
+  for(auto i=0; i < (int) rets.size(); ++i)
+    os << "  case " << i << ": goto " << rets[i] << ";\n";
+  os << "  }\n";
+  os << "}\n\n";
+
+  os << "}\n\n";
+  os << "int main(){\n";
+  os << "  return czlab::basic::rt.main(czlab::basic::run);\n";
+  os << "}\n\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Emitter::out(cstdstr& code){
+  body += stdstr(2*depth, ' ') + code + "\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Emitter::line(int p){ pos=p; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Emitter::stmt(int off){
+  // every statement can be jumped to.
+  body += label(pos,off) + ":;\n";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Emitter::label(int p, int off) const{
+  if(p < (int) counts.size() && off >= counts[p]){
+    ++p;
+    off=0; }
+  return "P" + N_STR(p) + "_" + N_STR(off);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Emitter::konst(const Value& v){
+  auto s= literal(v);
+  for(auto i=0; i < (int) consts.size(); ++i)
+    if(consts[i] == s) return "K[" + N_STR(i) + "]";
+  s__conj(consts, s);
+  return "K[" + N_STR(consts.size()-1) + "]";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Emitter::var(int slot) const{
+  return "S[" + N_STR(slot) + "]";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Emitter::name(int slot) const{
+  return quote(vm->slotName(slot));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Emitter::addr(d::Addr m) const{
+  return "DMARK(" + N_STR(m.first) + "," + N_STR(m.second) + ")";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Emitter::loop(DslFLInfo f){
+  s__conj(loops, "ForLoopInfo::make(" + quote(f->var) + ", " +
+                 N_STR(f->begin) + ", " + N_STR(f->beginOffset) + ")");
+  return "F" + N_STR(loops.size()-1);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Emitter::site(int p, int off){
+  s__conj(rets, label(p,off));
+  return rets.size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Emitter::defun(int slot, const IntVec& params, cstdstr& code){
+  stdstr f, pms;
+  auto z= (int) params.size();
+  for(auto i=0; i < z; ++i)
+    pms += stdstr(i > 0 ? ", " : "") + "const Value& a" + N_STR(i);
+  f += "static Value FN" + N_STR(slot) + "(" + pms + "){\n";
+  for(auto i=0; i < z; ++i)
+    f += "  auto s" + N_STR(i) + "= rt.bind(" +
+         name(params[i]) + ", " + var(params[i]) + ", a" + N_STR(i) + ");\n";
+  f += "  auto r= " + code + ";\n";
+  for(auto i=0; i < z; ++i)
+    f += "  " + var(params[i]) + "= s" + N_STR(i) + ";\n";
+  f += "  return r;\n}\n";
+  fns[slot]=f;
+  arity[slot]=z;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Emitter::call(int slot, const StrVec& args, d::Addr m){
+  stdstr pms;
+  for(auto& a : args)
+    pms += stdstr(pms.empty() ? "" : ", ") + a;
+
+  auto vn= vm->slotName(slot);
+  if(auto f= vm->getLambda(vn); f){
+    auto z= DCAST(Lambda,f)->arity();
+    if(z != (int) args.size())
+      return "(throw d::BadArity(" + N_STR(z) + ", " +
+             N_STR(args.size()) + "), Value())";
+    return "FN" + N_STR(slot) + "(" + pms + ")";
+  }
+
+  if(auto f= native_name(vn); !f.empty())
+    return "rt.call(&" + f + ", " + var(slot) + ", ValueVec{" + pms + "}, " +
+           name(slot) + ", " + addr(m) + ")";
+
+  return "rt.get(" + var(slot) + ", ValueVec{" + pms + "}, " +
+         name(slot) + ", " + addr(m) + ")";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static StrVec cpp_args(Emitter* e, d::AstVec& args){
+  StrVec out;
+  for(auto& a : args)
+    s__conj(out, DCAST(Ast,a)->cpp(e));
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static stdstr join(const StrVec& v){
+  stdstr buf;
+  for(auto& s : v)
+    buf += stdstr(buf.empty() ? "" : ", ") + s;
+  return buf;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Program::cpp(Emitter* e){
+  IntVec nums, sizes;
+  for(auto& i : vlines){
+    s__conj(nums, DCAST(Compound,i)->line());
+    s__conj(sizes, DCAST(Compound,i)->count()); }
+  e->lines(nums, sizes);
+  for(auto i=0; i < (int) vlines.size(); ++i){
+    e->line(i);
+    DCAST(Ast,vlines[i])->cpp(e); }
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Compound::cpp(Emitter* e){
+  auto src= N_STR(line()) + " " + pr_str();
+  // a trailing backslash would splice the next line in.
+  while(!src.empty() && src.back() == '\\') src.pop_back();
+  e->out("// " + src);
+  for(auto i=0; i < (int) stmts.size(); ++i){
+    e->stmt(i);
+    DCAST(Ast,stmts[i])->cpp(e); }
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Assignment::cpp(Emitter* e){
+  auto res= DCAST(Ast,rhs)->cpp(e);
+  if(DCAST(Ast,lhs)->tok()->type() == T_ARRAYINDEX){
+    auto fc= DCAST(FuncCall,lhs);
+    auto n= DCAST(Var,fc->funcName())->slot();
+    e->out("{ auto r= " + res + ";");
+    e->out("  rt.set(" + e->var(n) + ", ValueVec{" +
+           join(cpp_args(e, fc->funcArgs())) + "}, " +
+           e->name(n) + ", r, " + e->addr(tok()->addr()) + "); }");
+  }else{
+    auto n= DCAST(Var,lhs)->slot();
+    e->out(e->var(n) + "= " +
+           (typed ? res : "rt.checked(" + e->name(n) + ", " + res + ")") + ";"); }
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Print::cpp(Emitter* e){
+  auto lastSemi=false;
+  for(auto& i : exprs){
+    auto t= DCAST(Ast,i)->tok()->type();
+    lastSemi=false;
+    if(t == d::T_COMMA)
+      e->out("rt.write(\" \");");
+    else
+    if(t == d::T_SEMI)
+      lastSemi=true;
+    else
+      e->out("rt.print(" + DCAST(Ast,i)->cpp(e) + ");"); }
+  if(tok()->type() == T_PRINTLN || !lastSemi)
+    e->out("rt.writeln();");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr PrintSep::cpp(Emitter*){ return ""; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Input::cpp(Emitter* e){
+  auto n= DCAST(Var,var)->slot();
+  e->out(e->var(n) + "= rt.input(" + e->name(n) + ");");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Read::cpp(Emitter* e){
+  auto _A= e->addr(tok()->addr());
+  for(auto& v : vars){
+    if(DCAST(Ast,v)->tok()->type() == T_ARRAYINDEX){
+      auto fc= DCAST(FuncCall,v);
+      auto n= DCAST(Var,fc->funcName())->slot();
+      e->out("{ auto r= rt.read(" + _A + ");");
+      e->out("  rt.set(" + e->var(n) + ", ValueVec{" +
+             join(cpp_args(e, fc->funcArgs())) + "}, " +
+             e->name(n) + ", r, " + _A + "); }");
+    }else{
+      auto n= DCAST(Var,v)->slot();
+      e->out(e->var(n) + "= rt.checked(" +
+             e->name(n) + ", rt.read(" + _A + "));"); } }
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Data::cpp(Emitter* e){
+  // all data is loaded up front, same as the analyzer does.
+  for(auto& x : data)
+    e->data(DCAST(Ast,x)->cpp(e));
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Restore::cpp(Emitter* e){
+  return e->out("rt.restore();"), "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr End::cpp(Emitter* e){
+  return e->out("return;"), "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Run::cpp(Emitter*){ return ""; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Comment::cpp(Emitter*){ return ""; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Defun::cpp(Emitter* e){
+  IntVec pms;
+  for(auto& p : params)
+    s__conj(pms, DCAST(Var,p)->slot());
+  e->defun(DCAST(Var,var)->slot(), pms, DCAST(Ast,body)->cpp(e));
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr ArrayDecl::cpp(Emitter* e){
+  auto n= DCAST(Var,var)->slot();
+  auto _A= e->addr(tok()->addr());
+  stdstr dims;
+  for(auto& x : sizes)
+    dims += stdstr(dims.empty() ? "" : ", ") +
+            "BArray::dim(" + DCAST(Ast,x)->cpp(e) + ", " + _A + ")";
+  e->out(e->var(n) + "= Value::make(BArray::make(IntVec{" + dims + "}, " +
+         N_STR(array_type(DCAST(Var,var)->name())) + ", " +
+         (sparse ? "true" : "false") + "));");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr MatStmt::cpp(Emitter* e){
+  auto x= lhs ? DCAST(Ast,lhs)->cpp(e) : stdstr("Value()");
+  auto y= rhs ? DCAST(Ast,rhs)->cpp(e) : stdstr("Value()");
+  e->out("mat_run(" + N_STR(op) + ", " + e->var(DCAST(Var,var)->slot()) +
+         ", " + x + ", " + y + ", " + e->addr(tok()->addr()) + ");");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Goto::cpp(Emitter* e){
+  if(target >= 0)
+    e->out("goto " + e->label(target,0) + ";");
+  else{
+    e->out("line= (int) vnum(" + DCAST(Ast,expr)->cpp(e) + ", " +
+           e->addr(tok()->addr()) + ").getInt();");
+    e->out("sub=0;");
+    e->out("goto jump;"); }
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr GoSub::cpp(Emitter* e){
+  // RETURN resumes at the statement after this one.
+  e->out("rt.gosub(" + N_STR(e->site(e->pc(), offset()+1)) + ");");
+  if(target >= 0)
+    e->out("goto " + e->label(target,0) + ";");
+  else{
+    e->out("line= (int) vnum(" + DCAST(Ast,expr)->cpp(e) + ", " +
+           e->addr(tok()->addr()) + ").getInt();");
+    e->out("sub=1;");
+    e->out("goto jump;"); }
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr GoSubReturn::cpp(Emitter* e){
+  return e->out("goto ret;"), "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr OnXXX::cpp(Emitter* e){
+  auto sub= tok()->type() == T_GOSUB;
+  e->out("switch(vnum(" + DCAST(Ast,var)->cpp(e) + ", " +
+         e->addr(tok()->addr()) + ").getInt()){");
+  for(auto i=0; i < (int) posns.size(); ++i){
+    stdstr s= "case " + N_STR(i+1) + ": ";
+    if(sub)
+      s += "rt.gosub(" + N_STR(e->site(e->pc(), offset()+1)) + "); ";
+    e->out(s + "goto " + e->label(posns[i],0) + ";"); }
+  e->out("}");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr ForLoop::cpp(Emitter* e){
+  auto f= e->loop(info);
+  auto n= DCAST(Var,var)->slot();
+  auto _A= e->addr(tok()->addr());
+  auto done= "goto " + e->label(info->endPos, info->endOffset+1) + ";";
+  e->out("if(!" + f + "->init){");
+  e->out("  rt.forBegin(*" + f + ", " + DCAST(Ast,term)->cpp(e) +
+         ", " + DCAST(Ast,step)->cpp(e) + ", " + _A + ");");
+  e->out("  if(rt.forInit(*" + f + ", " + e->var(n) + ", " +
+         DCAST(Ast,init)->cpp(e) + ", " + _A + ")) " + done);
+  e->out("}else");
+  e->out("if(rt.forNext(*" + f + ", " + e->var(n) + ", " + _A + ")) " + done);
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr ForNext::cpp(Emitter* e){
+  // back to the FOR, which steps and tests.
+  e->out("goto " + e->label(info->beginPos, info->beginOffset) + ";");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr IfThen::cpp(Emitter* e){
+  e->out("if(rt.truth(" + DCAST(Ast,cond)->cpp(e) + ", " +
+         e->addr(tok()->addr()) + ")){");
+  e->indent(1);
+  DCAST(Ast,then)->cpp(e);
+  e->indent(-1);
+  if(elze){
+    e->out("}else{");
+    e->indent(1);
+    DCAST(Ast,elze)->cpp(e);
+    e->indent(-1); }
+  e->out("}");
+  return "";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr BoolTerm::cpp(Emitter* e){
+  auto _A= e->addr(tok()->addr());
+  // passed through, but still has to be a number.
+  if(terms.size() == 1)
+    return "Value(vnum(" + DCAST(Ast,terms[0])->cpp(e) + ", " + _A + "))";
+  stdstr buf;
+  for(auto& t : terms)
+    buf += stdstr(buf.empty() ? "" : " && ") +
+           "rt.truth(" + DCAST(Ast,t)->cpp(e) + ", " + _A + ")";
+  return "Value::make((" + buf + ") ? 1 : 0)";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr BoolExpr::cpp(Emitter* e){
+  if(terms.size() == 1)
+    return DCAST(Ast,terms[0])->cpp(e);
+  auto _A= e->addr(tok()->addr());
+  auto truth= [&](int i){
+    return "rt.truth(" + DCAST(Ast,terms[i])->cpp(e) + ", " + _A + ")"; };
+  // a true OR stops the whole chain.
+  stdstr buf= "[&]{ bool r= " + truth(0) + "; ";
+  for(auto i=0; i < (int) ops.size(); ++i){
+    if(ops[i]->type() == T_XOR)
+      buf += "r= (r != " + truth(i+1) + "); ";
+    else
+      buf += "if(r) return Value::make(1); r= " + truth(i+1) + "; "; }
+  return buf + "return Value::make(r ? 1 : 0); }()";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr RelationOp::cpp(Emitter* e){
+  auto x= DCAST(Ast,lhs)->cpp(e);
+  auto y= DCAST(Ast,rhs)->cpp(e);
+  auto k= N_STR(tok()->type());
+  return typed ? "op_relnum(" + x + ", " + k + ", " + y + ")"
+               : "op_relation(" + x + ", " + k + ", " + y + ", " +
+                 e->addr(tok()->addr()) + ")";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr BinOp::cpp(Emitter* e){
+  auto x= DCAST(Ast,lhs)->cpp(e);
+  auto y= DCAST(Ast,rhs)->cpp(e);
+  auto k= N_STR(tok()->type());
+  return typed ? "op_math(" + x + ", " + k + ", " + y + ")"
+               : "op_binary(" + x + ", " + k + ", " + y + ", " +
+                 e->addr(tok()->addr()) + ")";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr NotFactor::cpp(Emitter* e){
+  return "rt.negate(" + DCAST(Ast,expr)->cpp(e) + ", " +
+         e->addr(tok()->addr()) + ")";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr UnaryOp::cpp(Emitter* e){
+  return "rt.unary(" + N_STR(tok()->type()) + ", " +
+         DCAST(Ast,expr)->cpp(e) + ", " + e->addr(tok()->addr()) + ")";
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr FuncCall::cpp(Emitter* e){
+  return e->call(DCAST(Var,fn)->slot(), cpp_args(e,args), tok()->addr());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Num::cpp(Emitter* e){ return e->konst(num); }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr String::cpp(Emitter* e){ return e->konst(str); }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Var::cpp(Emitter* e){ return e->var(_slot); }
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,119 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "parser.h"
+#include "builtins.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// runtime for programs translated by --emit-cpp,
+// same semantics as the tree walker.
+struct Aot{
+
+  int main(void (*run)());
+
+  void write(cstdstr&);
+  void print(const Value&);
+  void writeln();
+  Value input(cstdstr& var);
+
+  Value read(d::Addr);
+  void restore(){ dataPtr=0; }
+
+  bool truth(const Value& v, d::Addr m){ return !vnum(v,m).isZero(); }
+  Value unary(int op, const Value&, d::Addr);
+  Value negate(const Value&, d::Addr);
+  Value checked(cstdstr& var, const Value& v){
+    return ensure_data_type(var,v), v; }
+  // bind a DEF FN arg, returns what was in the slot.
+  Value bind(cstdstr& var, Value& slot, const Value&);
+
+  Value get(const Value& arr, const ValueVec& args, cstdstr& var, d::Addr);
+  // call the native directly, unless the slot was DIMed over it.
+  Value call(Invoker, const Value& slot,
+             const ValueVec& args, cstdstr& var, d::Addr);
+  void set(const Value& arr, const ValueVec& args,
+           cstdstr& var, const Value&, d::Addr);
+
+  void forBegin(ForLoopInfo&, const Value& term, const Value& step, d::Addr);
+  // true when the loop is done.
+  bool forInit(ForLoopInfo&, Value& var, const Value& init, d::Addr);
+  bool forNext(ForLoopInfo&, Value& var, d::Addr);
+
+  void gosub(int site){ s__conj(returns, site); }
+  int ret();
+  void bad(int line, bool sub);
+
+  ValueVec data;
+  IntVec returns;
+  int dataPtr=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Emitter{
+
+  // write the checked tree out as a C++ program.
+  void emit(d::DAst, std::ostream&);
+
+  void out(cstdstr&);
+  void indent(int n){ depth += n; }
+  void line(int pos);
+  void stmt(int off);
+
+  stdstr konst(const Value&);
+  stdstr var(int slot) const;
+  stdstr name(int slot) const;
+  stdstr addr(d::Addr) const;
+  // a statement start, past the end means the next line.
+  stdstr label(int pos, int off) const;
+  stdstr loop(DslFLInfo);
+  int site(int pos, int off);
+  void data(cstdstr& code){ s__conj(items, code); }
+  void defun(int slot, const IntVec& params, cstdstr& body);
+  stdstr call(int slot, const StrVec& args, d::Addr);
+
+  int pc() const{ return pos; }
+  void lines(const IntVec& nums, const IntVec& sizes){
+    lineNums=nums; counts=sizes; }
+
+  Emitter(Basic* b) : vm(b){}
+  ~Emitter(){}
+
+  private:
+
+  Basic* vm;
+  int pos=0;
+  int depth=1;
+  IntVec lineNums;
+  IntVec counts;
+  StrVec consts;
+  StrVec loops;
+  StrVec items;
+  StrVec rets;
+  std::map<int,stdstr> fns;
+  std::map<int,int> arity;
+  stdstr body;
+};
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
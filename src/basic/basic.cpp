@@ -13,8 +13,10 @@
  * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
 
 #include <iostream>
-#include "parser.h"
+#include "vm.h"
+#include "fold.h"
 #include "builtins.h"
+#include "aot.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::basic{
@@ -26,24 +28,32 @@ d::DFrame Basic::root_env(){
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Basic::interpret(){
-  BasicParser p(source);
+  BasicParser p(source, length, options & O_PAR);
   root_env();
   dataSlots.clear();
   defs.clear();
   auto tree= p.parse();
   DEBUG("%s", PRN(tree));
-  return check(tree), eval(tree);
+  if(options & O_FOLD)
+    Folder().run(tree);
+  check(tree);
+  if(options & O_CPP)
+    return Emitter(this).emit(tree, std::cout), DVAL_NIL;
+  return (options & O_VM) ? exec(tree) : eval(tree);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::addData(d::DValue v){
-  DEBUG("addData(): %s", PRV(v,0));
+Basic::~Basic(){ DEL_PTR(code); }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Basic::addData(const Value& v){
+  DEBUG("addData(): %s", C_STR(v.pr_str(0)));
   s__conj(dataSlots,v);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue Basic::readData(){
-  return s__index(dataPtr,dataSlots) ? dataSlots[dataPtr++] : DVAL_NIL; }
+Value Basic::readData(){
+  return s__index(dataPtr,dataSlots) ? dataSlots[dataPtr++] : Value(); }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Basic::restore(){ dataPtr=0; }
@@ -60,6 +70,17 @@ d::DValue Basic::eval(d::DAst tree){
   return (finz_counters(), res);
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Basic::exec(d::DAst tree){
+  // lower the checked tree into bytecode, then run it.
+  DEL_PTR(code);
+  code= Compiler().compile(tree);
+  DEBUG("%s", code->pr_str().c_str());
+  init_counters();
+  auto res= VM(this).run(*code);
+  return (finz_counters(), res);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame Basic::pushFrame(cstdstr& name){
   return (stack = d::Frame::make(name, stack));
@@ -87,17 +108,35 @@ d::DValue Basic::setValueEx(cstdstr& name, d::DValue v){
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Basic::setValue(cstdstr& name, d::DValue v){
+  if(auto i= slotIds.find(name);
+     i != slotIds.end()) { return setSlot(_2_(i), Value::make(v)), v; }
   auto x = peekFrame();
-  ensure_data_type(name,v);
+  ensure_data_type(name,Value::make(v));
   return x ? x->set(name, v) : DVAL_NIL;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Basic::getValue(cstdstr& name) const{
+  if(auto i= slotIds.find(name);
+     i != slotIds.end()) { return slots[_2_(i)].box(); }
   auto x = peekFrame();
   return x ? x->get(name) : DVAL_NIL;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+const Value& Basic::setSlot(int n, const Value& v){
+  ensure_data_type(slotNames[n],v);
+  return (slots[n]= v);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Basic::slot(cstdstr& name){
+  if(auto i= slotIds.find(name);
+     i != slotIds.end()) { return _2_(i); }
+  s__conj(slotNames, name);
+  return (slotIds[name]= slotNames.size()-1);
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 static StrVec TYPES {"INT", "REAL", "STRING"};
 static std::map<stdstr,d::DSymbol> BITS {
@@ -109,6 +148,8 @@ static std::map<stdstr,d::DSymbol> BITS {
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void Basic::check(d::DAst tree){
   symbols= d::Table::make("root", BITS);
+  slotIds.clear();
+  slotNames.clear();
   tree->visit(this);
 }
 
@@ -175,8 +216,7 @@ void Basic::writeln(){ std::cout << "\n"; }
 void Basic::install(const std::map<int,int>& m){
   // install the entire program, maps code lines
   // to linear array positions.
-  for(auto& x : m)
-    lines[_1(x)] = _2(x);
+  lines.build(m);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -195,6 +235,14 @@ void Basic::init_lambdas(){
     setValue(p->name(), v);
     DEBUG("installed lambda: %s", p->name().c_str()); } }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Basic::init_slots(){
+  // natives start out in the root frame.
+  auto x= peekFrame();
+  slots.clear();
+  for(auto& n : slotNames)
+    s__conj(slots, Value::make(x ? x->get(n) : DVAL_NIL)); }
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 #define CLEAR_STACK(s) \
   do{ while (!s.empty()) s.pop(); }while(0)
@@ -205,6 +253,7 @@ void Basic::init_counters(){
   dataPtr=0;
   progOffset=0;
   progCounter= -1;
+  init_slots();
   init_lambdas();
   CLEAR_STACK(gosubReturns);
 }
@@ -232,51 +281,66 @@ int Basic::retSub(){
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int Basic::jumpSub(int target, int from, int off){
-  auto it= lines.find(target);
-  if(it == lines.end())
+  auto pos= lines.find(target);
+  if(pos < 0)
     RAISE(d::BadArg, "Bad gosub<%d>", target);
 
   // must!
-  ASSERT1(progCounter == lines[from]);
+  ASSERT1(progCounter == lines.find(from));
 
+  return jumpSubPos(pos, off);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Basic::jumpSubPos(int pos, int off){
   gosubReturns.push(s__pair(int,int,progCounter,off));
-  auto pc = _2_(it);
-  progOffset=0;
-  // go one less since pc always increments.
-  return (progCounter = pc-1);
+  return jumpPos(pos);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Basic::locate(int line) const{
+  return lines.find(line);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int Basic::jump(int line){
-  auto it= lines.find(line);
-  if(it == lines.end())
+  auto pos= lines.find(line);
+  if(pos < 0)
     RAISE(d::BadArg, "Bad goto<%d>", line);
-  auto pos = _2_(it);
+  return jumpPos(pos);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Basic::jumpPos(int pos){
   progOffset=0;
   // go one less since pc always increments.
   return (progCounter = pos-1);
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Basic::resolve(int line, bool sub, d::Addr m){
+  // constant targets are checked once, during analysis.
+  auto pos= locate(line);
+  if(pos < 0)
+    E_SEMANTIC("Bad %s<%d> near %s",
+               sub ? "gosub" : "goto", line, d::pr_addr(m).c_str());
+  return pos;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int Basic::jumpFor(DslFLInfo f){
-  auto it= lines.find(f->begin);
-  if(it == lines.end())
-    RAISE(d::BadArg, "Bad for-loop<%d>",  f->begin);
   progOffset=f->beginOffset;
   // always one less since pc always increments.
-  return (progCounter = _2_(it) - 1);
+  return (progCounter = f->beginPos - 1);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int Basic::endFor(DslFLInfo f){
-  auto it= lines.find(f->end);
-  if(it == lines.end())
-    RAISE(d::BadArg, "Bad end-for<%d>", f->end);
-  f->init=P_NIL;
+  f->init=Value();
   // when done goto next offset.
   progOffset=f->endOffset+1;
   // one less since pc always increments.
-  return (progCounter = _2_(it) - 1);
+  return (progCounter = f->endPos - 1);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -295,12 +359,12 @@ void Basic::addForLoop(DslFLInfo f){
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::xrefForNext(int n, int pos){
-  xrefForNext("", n, pos);
+DslFLInfo Basic::xrefForNext(int n, int pos){
+  return xrefForNext("", n, pos);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void Basic::xrefForNext(cstdstr& v, int n, int pos){
+DslFLInfo Basic::xrefForNext(cstdstr& v, int n, int pos){
   // make sure the next statement matches the current for loop.
   auto c = this->forLoop;
   // must!
@@ -313,41 +377,18 @@ void Basic::xrefForNext(cstdstr& v, int n, int pos){
 
   c->endOffset=pos;
   c->end= n;
-
-  // find the corresponding counters
-  auto b= this->lines[c->begin];
-  auto e= this->lines[c->end];
-
-  // we need to handle multi next on same line
-  auto bkey= N_STR(b)+","+N_STR(c->beginOffset);
-  auto ekey= N_STR(e)+","+N_STR(pos);
-
-  //std::cout << "bkey= " << bkey << "\n";
-  //std::cout << "ekey= " << ekey << "\n";
-
-  this->forBegins[bkey] = c;
-  this->forEnds[ekey] = c;
+  c->beginPos= locate(c->begin);
+  c->endPos= locate(c->end);
 
   // pop it
   forLoop=forLoop->outer;
+  return c;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-DslFLInfo Basic::getForLoop(int c, int offset) const{
-  auto k= N_STR(c)+","+N_STR(offset);
-
-  if(auto i = forBegins.find(k);
-      i != forBegins.end()) { return _2_(i); }
-
-  if(auto i = forEnds.find(k);
-      i != forEnds.end()) { return _2_(i); }
-
-  E_SEMANTIC("Unknown for-loop<%d>, offset[%d]", c, offset);
-}
-
-
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 //EOF
 
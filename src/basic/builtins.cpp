@@ -36,309 +36,359 @@ double rad_deg(double rad){
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static double to_dbl(d::DValue arg){
-  return vcast<d::Number>(arg,DMARK_00)->getFloat(); }
+static double to_dbl(const Value& arg){
+  return vnum(arg,DMARK_00).getFloat(); }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_pi(d::IEvaluator*, d::VSlice args){
+static BArray* numbers(const Value& arg, const char* fn){
+  auto a= vcast<BArray>(arg,DMARK_00);
+  ASSERT(a->elemType() != AT_STR,
+         "%s wanted a numeric array, got %s.", fn, C_STR(arg.pr_str(1)));
+  return a;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static void same_size(BArray* x, BArray* y, const char* fn){
+  ASSERT(x->size() == y->size(),
+         "%s wanted arrays of one size, got %d and %d.", fn, x->size(), y->size());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the array forms of a math function, f(A) in place or f(B,A) into B,
+// both give back the element count.
+static bool mapped(ValSlice args, double (*fn)(double), const char* name, Value& res){
+  if(args.size() == 0 || !vcast<BArray>(*args.begin)) return false;
+  auto len= d::preMin(1, args.size(), name);
+  auto dst= numbers(*args.begin, name);
+  auto src= len > 1 ? numbers(*(args.begin+1), name) : dst;
+  same_size(dst, src, name);
+  dst->map(fn, *src);
+  res= Value::make(dst->size());
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_pi(d::IEvaluator*, ValSlice args){
   d::preEqual(0, args.size(), "pi");
-  return NUMBER_VAL(PI);
+  return Value::make(PI);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_cos(d::IEvaluator*, d::VSlice args){
+Value native_cos(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "cos");
-  return NUMBER_VAL(::cos(to_dbl(*args.begin)));
+  return Value::make(::cos(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_sin(d::IEvaluator*, d::VSlice args){
+Value native_sin(d::IEvaluator*, ValSlice args){
+  if(Value res; mapped(args, ::sin, "sin", res)) return res;
   d::preEqual(1, args.size(), "sin");
-  return NUMBER_VAL(::sin(to_dbl(*args.begin)));
+  return Value::make(::sin(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_tan(d::IEvaluator*, d::VSlice args){
+Value native_tan(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "tan");
-  return NUMBER_VAL(::tan(to_dbl(*args.begin)));
+  return Value::make(::tan(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_acs(d::IEvaluator*, d::VSlice args){
+Value native_acs(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "acs");
-  return NUMBER_VAL(::acos(to_dbl(*args.begin)));
+  return Value::make(::acos(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_asn(d::IEvaluator* e, d::VSlice args){
+Value native_asn(d::IEvaluator* e, ValSlice args){
   d::preEqual(1, args.size(), "asn");
-  return NUMBER_VAL(::asin(to_dbl(*args.begin)));
+  return Value::make(::asin(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_atn(d::IEvaluator* e, d::VSlice args){
+Value native_atn(d::IEvaluator* e, ValSlice args){
   d::preEqual(1, args.size(), "atn");
-  return NUMBER_VAL(::atan(to_dbl(*args.begin)));
+  return Value::make(::atan(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_sinh(d::IEvaluator*, d::VSlice args){
+Value native_sinh(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "sinh");
-  return NUMBER_VAL(::sinh(to_dbl(*args.begin)));
+  return Value::make(::sinh(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_cosh(d::IEvaluator*, d::VSlice args){
+Value native_cosh(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "cosh");
-  return NUMBER_VAL(::cosh(to_dbl(*args.begin)));
+  return Value::make(::cosh(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_tanh(d::IEvaluator*, d::VSlice args){
+Value native_tanh(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "tanh");
-  return NUMBER_VAL(::tanh(to_dbl(*args.begin)));
+  return Value::make(::tanh(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_asinh(d::IEvaluator*, d::VSlice args){
+Value native_asinh(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "asinh");
-  return NUMBER_VAL(::asinh(to_dbl(*args.begin)));
+  return Value::make(::asinh(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_acosh(d::IEvaluator*, d::VSlice args){
+Value native_acosh(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "acosh");
-  return NUMBER_VAL(::acosh(to_dbl(*args.begin)));
+  return Value::make(::acosh(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_atanh(d::IEvaluator*, d::VSlice args){
+Value native_atanh(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "atanh");
-  return NUMBER_VAL(::atanh(to_dbl(*args.begin)));
+  return Value::make(::atanh(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_exp(d::IEvaluator*, d::VSlice args){
+Value native_exp(d::IEvaluator*, ValSlice args){
+  if(Value res; mapped(args, ::exp, "exp", res)) return res;
   d::preEqual(1, args.size(), "exp");
-  return NUMBER_VAL(::exp(to_dbl(*args.begin)));
+  return Value::make(::exp(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_log(d::IEvaluator*, d::VSlice args){
+Value native_log(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "log");
-  return NUMBER_VAL(::log(to_dbl(*args.begin)));
+  return Value::make(::log(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 /*
-static d::DValue native_ln(d::IEvaluator*, d::VSlice args) {
+static Value native_ln(d::IEvaluator*, ValSlice args) {
   d::preEqual(1, args.size(), "ln");
-  return NUMBER_VAL(::log10(to_dbl(*args.begin)));
+  return Value::make(::log10(to_dbl(*args.begin)));
 }
 */
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_abs(d::IEvaluator*, d::VSlice args){
+Value native_abs(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "abs");
-  return NUMBER_VAL(::abs(to_dbl(*args.begin)));
+  return Value::make(::abs(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_sqrt(d::IEvaluator*, d::VSlice args){
+Value native_sqrt(d::IEvaluator*, ValSlice args){
+  if(Value res; mapped(args, ::sqrt, "sqr", res)) return res;
   d::preEqual(1, args.size(), "sqr");
-  return NUMBER_VAL(::sqrt(to_dbl(*args.begin)));
+  return Value::make(::sqrt(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_cbrt(d::IEvaluator*, d::VSlice args){
+Value native_cbrt(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "cur");
-  return NUMBER_VAL(::cbrt(to_dbl(*args.begin)));
+  return Value::make(::cbrt(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_sign(d::IEvaluator*, d::VSlice args){
+Value native_sign(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "sgn");
   auto d = to_dbl(*args.begin);
-  return NUMBER_VAL(d > 0 ? 1 : (d < 0 ? -1 : 0));
+  return Value::make(d > 0 ? 1 : (d < 0 ? -1 : 0));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_int(d::IEvaluator*, d::VSlice args){
+Value native_int(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "int");
   auto d = ::floor(to_dbl(*args.begin));
-  return NUMBER_VAL((int)d);
+  return Value::make((int)d);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_round(d::IEvaluator*, d::VSlice args){
+Value native_round(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "round");
-  return NUMBER_VAL(::round(to_dbl(*args.begin)));
+  return Value::make(::round(to_dbl(*args.begin)));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_frac(d::IEvaluator*, d::VSlice args){
+Value native_frac(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "frac");
   auto d= to_dbl(*args.begin);
   auto i=0.0;
-  return NUMBER_VAL(::modf(d, &i));
+  return Value::make(::modf(d, &i));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_fix(d::IEvaluator*, d::VSlice args){
+Value native_fix(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "fix");
   auto d= to_dbl(*args.begin);
   double i;
  ::modf(d, &i);
-  return NUMBER_VAL((int) i);
+  return Value::make((int) i);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_rand(d::IEvaluator*, d::VSlice args){
+Value native_rand(d::IEvaluator*, ValSlice args){
   //d::preEqual(0, args.size(), "rnd");
   std::random_device rd;
   std::mt19937 gen(rd());
   std::uniform_real_distribution<> dis(0, 1);
-  return NUMBER_VAL(dis(gen));
+  return Value::make(dis(gen));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_chr(d::IEvaluator*, d::VSlice args){
+Value native_chr(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "chr$");
-  int v= vcast<d::Number>(*(args.begin),DMARK_00)->getInt();
+  int v= vnum(*(args.begin),DMARK_00).getInt();
   ASSERT(v>=0&&v<=255, "Bad arg value: %d.", v);
   stdstr s {(char)v};
-  return STRING_VAL(s);
+  return Value::make(s);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_asc(d::IEvaluator*, d::VSlice args){
+Value native_asc(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "asc");
   auto s= vcast<d::String>(*(args.begin),DMARK_00)->impl();
   ASSERT(s.size() > 0, "Bad string: %s.", C_STR(s));
-  return NUMBER_VAL((int) s[0]);
+  return Value::make((int) s[0]);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_val(d::IEvaluator*, d::VSlice args){
+Value native_val(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "val");
   auto v= vcast<d::String>(*(args.begin),DMARK_00)->impl();
   auto s= v.c_str();//vcast<d::String>(*(args.begin),DMARK_00)->impl().c_str();
   if(::strchr(s, '.')){
-    return NUMBER_VAL(::atof(s));
+    return Value::make(::atof(s));
   }else{
-    return NUMBER_VAL(::atoi(s));
+    return Value::make(::atoi(s));
   }
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_right(d::IEvaluator*, d::VSlice args){
+Value native_right(d::IEvaluator*, ValSlice args){
   d::preEqual(2, args.size(), "right$");
   auto s= vcast<d::String>(*(args.begin),DMARK_00)->impl();
   auto z= s.size();
-  auto w= vcast<d::Number>(*(args.begin+1),DMARK_00)->getInt();
+  auto w= vnum(*(args.begin+1),DMARK_00).getInt();
 
   if(w <= 0)
-    return STRING_VAL("");
+    return Value::make("");
 
   if(w >= z)
-    return STRING_VAL(s);
+    return Value::make(s);
 
   Tchar buf[z+1];
   int cz= s.copy(buf,w, z-w);
   buf[cz]='\0';
-  return STRING_VAL(buf);
+  return Value::make(buf);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_left(d::IEvaluator*, d::VSlice args){
+Value native_left(d::IEvaluator*, ValSlice args){
   d::preEqual(2, args.size(), "left$");
   auto s= vcast<d::String>(*(args.begin),DMARK_00)->impl();
   auto z= s.size();
-  auto w= vcast<d::Number>(*(args.begin+1),DMARK_00)->getInt();
+  auto w= vnum(*(args.begin+1),DMARK_00).getInt();
 
   if(w <= 0)
-    return STRING_VAL("");
+    return Value::make("");
 
   if(w >= z)
-    return STRING_VAL(s);
+    return Value::make(s);
 
   Tchar buf[z+1];
   int cz= s.copy(buf,w, 0);
   buf[cz]='\0';
-  return STRING_VAL(buf);
+  return Value::make(buf);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_mid(d::IEvaluator*, d::VSlice args){
+Value native_mid(d::IEvaluator*, ValSlice args){
   auto len=d::preMin(2, args.size(), "mid$");
   auto s= vcast<d::String>(*(args.begin),DMARK_00)->impl();
   auto z= s.size();
   auto w=z;
-  auto pos= vcast<d::Number>(*(args.begin+1),DMARK_00)->getInt();
+  auto pos= vnum(*(args.begin+1),DMARK_00).getInt();
   if(pos >=0 && pos < z){}else{
-    return STRING_VAL("");
+    return Value::make("");
   }
   if(len > 2)
-    w= vcast<d::Number>(*(args.begin+2),DMARK_00)->getInt();
+    w= vnum(*(args.begin+2),DMARK_00).getInt();
   ASSERT1(w >=0);
   Tchar buf[z+1];
   int cz= s.copy(buf,w,pos);
   buf[cz]='\0';
-  return STRING_VAL(buf);
+  return Value::make(buf);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_len(d::IEvaluator*, d::VSlice args){
+Value native_len(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "len");
   auto s= vcast<d::String>(*(args.begin),DMARK_00)->impl();
-  return NUMBER_VAL((int)s.size());
+  return Value::make((int)s.size());
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_str(d::IEvaluator*, d::VSlice args){
+Value native_str(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "str$");
-  auto n= vcast<d::Number>(*(args.begin),DMARK_00);
+  auto& n= vnum(*(args.begin),DMARK_00);
   stdstr s;
-  if(n->isInt())
-    s= N_STR(n->getInt()); else s=N_STR(n->getFloat());
-  return STRING_VAL(s);
+  if(n.isInt())
+    s= N_STR(n.getInt()); else s=N_STR(n.getFloat());
+  return Value::make(s);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-static d::DValue native_spc(d::IEvaluator*, d::VSlice args){
+Value native_spc(d::IEvaluator*, ValSlice args){
   d::preEqual(1, args.size(), "spc");
-  auto n= vcast<d::Number>(*(args.begin),DMARK_00);
+  auto& n= vnum(*(args.begin),DMARK_00);
   stdstr s;
-  if(n->isInt() && n->getInt() > 0){
-    s= stdstr((int)n->getInt(), ' ');
+  if(n.isInt() && n.getInt() > 0){
+    s= stdstr((int)n.getInt(), ' ');
   }
-  return STRING_VAL(s);
+  return Value::make(s);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_sum(d::IEvaluator*, ValSlice args){
+  d::preEqual(1, args.size(), "sum");
+  return numbers(*args.begin, "sum")->sum();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static Value extreme(ValSlice args, bool hi, const char* name){
+  auto len= d::preMin(1, args.size(), name);
+  if(len == 1 && vcast<BArray>(*args.begin))
+    return numbers(*args.begin, name)->extreme(hi);
+  // or a list of numbers.
+  auto res= vnum(*args.begin,DMARK_00);
+  for(auto i=1; i < len; ++i){
+    auto& v= vnum(*(args.begin+i),DMARK_00);
+    if(hi ? v.getFloat() > res.getFloat()
+          : v.getFloat() < res.getFloat()) res=v; }
+  return res;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_min(d::IEvaluator*, ValSlice args){
+  return extreme(args, false, "min");
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_max(d::IEvaluator*, ValSlice args){
+  return extreme(args, true, "max");
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_mean(d::IEvaluator*, ValSlice args){
+  d::preEqual(1, args.size(), "mean");
+  auto a= numbers(*args.begin, "mean");
+  return Value::make(a->sum().getFloat() / a->size());
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_dot(d::IEvaluator*, ValSlice args){
+  d::preEqual(2, args.size(), "dot");
+  auto x= numbers(*args.begin, "dot");
+  auto y= numbers(*(args.begin+1), "dot");
+  same_size(x, y, "dot");
+  return x->dot(*y);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_fill(d::IEvaluator*, ValSlice args){
+  d::preEqual(2, args.size(), "fill");
+  auto a= vcast<BArray>(*args.begin,DMARK_00);
+  a->fill(*(args.begin+1));
+  return Value::make(a->size());
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value native_copy(d::IEvaluator*, ValSlice args){
+  d::preEqual(2, args.size(), "copy");
+  auto dst= vcast<BArray>(*args.begin,DMARK_00);
+  auto src= vcast<BArray>(*(args.begin+1),DMARK_00);
+  same_size(dst, src, "copy");
+  dst->copy(*src);
+  return Value::make(dst->size());
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 #define REG(env,fn,arg) env->set(fn, FN_VAL(fn, &arg))
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame init_natives(d::DFrame env){
-  //trig funcs
-  REG(env,"SIN", native_sin);
-  REG(env, "COS", native_cos);
-  REG(env, "TAN", native_tan);
-  REG(env, "ASN", native_asn);
-  REG(env, "ACS", native_acs);
-  REG(env, "ATN", native_atn);
-  REG(env, "PI", native_pi);
-  REG(env, "HYPSIN", native_sinh);
-  REG(env, "HYPCOS", native_cosh);
-  REG(env, "HYPTAN", native_tanh);
-  REG(env, "HYPASN", native_asinh);
-  REG(env, "HYPACS", native_acosh);
-  REG(env, "HYPATN", native_atanh);
-
-  REG(env, "EXP", native_exp);
-  //REG(env, "LN", native_ln);
-  REG(env, "LOG", native_log);
-  REG(env, "ABS", native_abs);
-  REG(env, "INT", native_int);
-  REG(env, "SQR", native_sqrt);
-  REG(env, "CUR", native_cbrt);
-  REG(env, "SGN", native_sign);
-
-  REG(env, "ROUND", native_round);
-  REG(env, "FRAC", native_frac);
-  REG(env, "FIX", native_fix);
-
-  REG(env, "RAN#", native_rand);
-  REG(env, "RND", native_rand);
-
-  // string funcs
-  REG(env, "RIGHT$", native_right);
-  REG(env, "LEFT$", native_left);
-  REG(env, "CHR$", native_chr);
-  REG(env, "STR$", native_str);
-  REG(env, "MID$", native_mid);
-  REG(env, "ASC", native_asc);
-  REG(env, "VAL", native_val);
-  REG(env, "LEN", native_len);
-  REG(env, "SPC", native_spc);
-
-
-
-
-
-
-
-
+#define REG_NATIVE(n,f) REG(env, n, f);
+  BASIC_NATIVES(REG_NATIVE)
+#undef REG_NATIVE
   return env;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr native_name(cstdstr& n){
+#define NAME_NATIVE(n,f) {n, #f},
+  static std::map<stdstr,stdstr> names { BASIC_NATIVES(NAME_NATIVE) };
+#undef NAME_NATIVE
+  auto i= names.find(n);
+  return i != names.end() ? _2_(i) : "";
+}
+
 
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
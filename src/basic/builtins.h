@@ -18,8 +18,59 @@
 namespace czlab::basic{
 namespace d=czlab::dsl;
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// BASIC name => native routine.
+#define BASIC_NATIVES(X) \
+  X("SIN", native_sin) \
+  X("COS", native_cos) \
+  X("TAN", native_tan) \
+  X("ASN", native_asn) \
+  X("ACS", native_acs) \
+  X("ATN", native_atn) \
+  X("PI", native_pi) \
+  X("HYPSIN", native_sinh) \
+  X("HYPCOS", native_cosh) \
+  X("HYPTAN", native_tanh) \
+  X("HYPASN", native_asinh) \
+  X("HYPACS", native_acosh) \
+  X("HYPATN", native_atanh) \
+  X("EXP", native_exp) \
+  X("LOG", native_log) \
+  X("ABS", native_abs) \
+  X("INT", native_int) \
+  X("SQR", native_sqrt) \
+  X("CUR", native_cbrt) \
+  X("SGN", native_sign) \
+  X("ROUND", native_round) \
+  X("FRAC", native_frac) \
+  X("FIX", native_fix) \
+  X("RAN#", native_rand) \
+  X("RND", native_rand) \
+  X("RIGHT$", native_right) \
+  X("LEFT$", native_left) \
+  X("CHR$", native_chr) \
+  X("STR$", native_str) \
+  X("MID$", native_mid) \
+  X("ASC", native_asc) \
+  X("VAL", native_val) \
+  X("LEN", native_len) \
+  X("SPC", native_spc) \
+  X("SUM", native_sum) \
+  X("MIN", native_min) \
+  X("MAX", native_max) \
+  X("MEAN", native_mean) \
+  X("DOT", native_dot) \
+  X("FILL", native_fill) \
+  X("COPY", native_copy)
+
+#define DECL_NATIVE(n,f) Value f(d::IEvaluator*, ValSlice);
+BASIC_NATIVES(DECL_NATIVE)
+#undef DECL_NATIVE
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DFrame init_natives(d::DFrame);
+// the C++ routine behind a native, or "" if none.
+stdstr native_name(cstdstr&);
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -0,0 +1,333 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "fold.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace a= czlab::aeon;
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static bool candidate(const VarUse& u, int prefixEnd){
+  // assigned once, during the straight run at the top of the
+  // program, and never read before that.
+  return u.writes == 1 && u.site &&
+         (prefixEnd < 0 || u.seq < prefixEnd) &&
+         (u.firstRead < 0 || u.firstRead > u.seq);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::run(d::DAst tree){
+  scan=1;
+  seq=0;
+  DCAST(Ast,tree)->fold(this);
+  link();
+  scan=0;
+  seq=0;
+  DCAST(Ast,tree)->fold(this);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::link(){
+  // calling a user function also ends the straight run,
+  // its body may read anything.
+  for(auto& c : calls)
+    if(std::find(defs.begin(), defs.end(), _2(c)) != defs.end())
+      if(prefixEnd < 0 || _1(c) < prefixEnd) { prefixEnd= _1(c); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::fold(d::DAst& x){
+  if(auto r= DCAST(Ast,x)->fold(this); r && !scan) { x=r; }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Folder::isLit(d::DAst x) const{
+  return X_NIL(acast<Num>(x)) || X_NIL(acast<String>(x));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Folder::eval(Ast* x){
+  if(scan)
+    return P_NIL;
+  Value v;
+  try{
+    // literals only, so no evaluator is needed.
+    v= x->evalv(P_NIL);
+  }catch(const a::Error&){
+    // leave it to fail at runtime.
+    return P_NIL;
+  }
+  auto _A= x->tok()->addr();
+  if(v.isInt())
+    return Num::make(d::Token::make(v.pr_str(0), _A, v.getInt()));
+  if(v.isNum())
+    return Num::make(d::Token::make(v.pr_str(0), _A, v.getFloat()));
+  if(vcast<d::String>(v))
+    return String::make(d::Token::make(v.pr_str(0), _A));
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::control(){
+  if(scan && prefixEnd < 0)
+    prefixEnd=seq;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::call(cstdstr& n){
+  if(scan)
+    calls.emplace_back(seq,n);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::defun(cstdstr& n){
+  if(scan)
+    s__conj(defs, n);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::write(cstdstr& n){
+  if(scan){
+    auto& u= vars[n];
+    ++u.writes;
+    u.site=P_NIL; }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Folder::assign(Ast* a, cstdstr& n, d::DAst rhs){
+  if(scan){
+    auto& u= vars[n];
+    ++u.writes;
+    u.site=a;
+    u.seq=seq;
+  }else{
+    if(auto i= vars.find(n); i != vars.end() &&
+       _2_(i).site == a &&
+       candidate(_2_(i), prefixEnd) && isLit(rhs)) { consts[n]=rhs; } }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Folder::read(cstdstr& n){
+  if(scan){
+    // reads inside a DEF FN happen when it is called.
+    if(auto& u= vars[n]; !inDef && u.firstRead < 0) { u.firstRead=seq; }
+    return P_NIL;
+  }
+  auto i= consts.find(n);
+  return i == consts.end() ? P_NIL : _2_(i);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Program::fold(Folder* f){
+  for(auto& x : vlines)
+    f->fold(x);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Compound::fold(Folder* f){
+  for(auto& x : stmts){
+    f->next();
+    f->fold(x); }
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst FuncCall::fold(Folder* f){
+  f->call(PNAME(Var,fn));
+  for(auto& x : args)
+    f->fold(x);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BoolTerm::fold(Folder* f){
+  bool lit=1;
+  for(auto& x : terms){
+    f->fold(x);
+    lit = lit && f->isLit(x); }
+  return lit ? f->eval(this) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BoolExpr::fold(Folder* f){
+  bool lit=1;
+  for(auto& x : terms){
+    f->fold(x);
+    lit = lit && f->isLit(x); }
+  return lit ? f->eval(this) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst RelationOp::fold(Folder* f){
+  f->fold(lhs);
+  f->fold(rhs);
+  return f->isLit(lhs) && f->isLit(rhs) ? f->eval(this) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst NotFactor::fold(Folder* f){
+  f->fold(expr);
+  return f->isLit(expr) ? f->eval(this) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst BinOp::fold(Folder* f){
+  f->fold(lhs);
+  f->fold(rhs);
+  return f->isLit(lhs) && f->isLit(rhs) ? f->eval(this) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst UnaryOp::fold(Folder* f){
+  f->fold(expr);
+  return f->isLit(expr) ? f->eval(this) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Var::fold(Folder* f){
+  return f->read(name());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Assignment::fold(Folder* f){
+  f->fold(rhs);
+  if(auto v= acast<Var>(lhs); v)
+    f->assign(this, v->name(), rhs);
+  else
+    f->fold(lhs);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst End::fold(Folder* f){
+  return f->control(), P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Read::fold(Folder* f){
+  for(auto& x : vars)
+    if(auto v= acast<Var>(x); v)
+      f->write(v->name());
+    else
+      f->fold(x);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst GoSubReturn::fold(Folder* f){
+  return f->control(), P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst GoSub::fold(Folder* f){
+  f->control();
+  f->fold(expr);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Goto::fold(Folder* f){
+  f->control();
+  f->fold(expr);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst OnXXX::fold(Folder* f){
+  f->control();
+  f->fold(var);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Defun::fold(Folder* f){
+  f->defun(PNAME(Var,var));
+  for(auto& p : params)
+    f->write(PNAME(Var,p));
+  f->inDefun(true);
+  f->fold(body);
+  f->inDefun(false);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst ForNext::fold(Folder* f){
+  return f->control(), P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst ForLoop::fold(Folder* f){
+  f->control();
+  f->write(PNAME(Var,var));
+  f->fold(init);
+  f->fold(term);
+  f->fold(step);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Print::fold(Folder* f){
+  for(auto& x : exprs)
+    f->fold(x);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst IfThen::fold(Folder* f){
+  f->control();
+  f->fold(cond);
+  f->fold(then);
+  if(elze)
+    f->fold(elze);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Data::fold(Folder* f){
+  for(auto& x : data)
+    f->fold(x);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst Input::fold(Folder* f){
+  f->write(PNAME(Var,var));
+  if(prompt)
+    f->fold(prompt);
+  return P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst ArrayDecl::fold(Folder* f){
+  for(auto& x : sizes)
+    f->fold(x);
+  return f->write(PNAME(Var,var)), P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst MatStmt::fold(Folder* f){
+  // only the scalar is an expression, the rest are arrays.
+  if(op == MAT_SCALE)
+    f->fold(lhs);
+  return f->write(PNAME(Var,var)), P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,76 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "parser.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct VarUse{
+  int writes=0;
+  int firstRead= -1;
+  // seq of the one assignment, if any.
+  int seq= -1;
+  Ast* site=P_NIL;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Folder{
+
+  // scan the tree once for variable usage, then fold.
+  void run(d::DAst);
+
+  // replaces x if it folds to something else.
+  void fold(d::DAst& x);
+  bool scanning() const{ return scan; }
+  bool isLit(d::DAst) const;
+  d::DAst eval(Ast*);
+
+  // called by the nodes while walking.
+  void next(){ ++seq; }
+  void control();
+  void call(cstdstr&);
+  void defun(cstdstr&);
+  void inDefun(bool b){ inDef=b; }
+  void write(cstdstr&);
+  void assign(Ast*, cstdstr&, d::DAst rhs);
+  d::DAst read(cstdstr&);
+
+  Folder(){}
+  ~Folder(){}
+
+  private:
+
+  void link();
+
+  std::map<stdstr,VarUse> vars;
+  std::map<stdstr,d::DAst> consts;
+  std::vector<std::pair<int,stdstr>> calls;
+  StrVec defs;
+  // seq of the first statement that may not run
+  // straight through, -1 if none.
+  int prefixEnd= -1;
+  bool inDef=0;
+  bool scan=1;
+  int seq=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,421 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include <cstring>
+#include "jit.h"
+#if UBASIC_JIT
+#include <sys/mman.h>
+#endif
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace a= czlab::aeon;
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::shared_ptr<JitCode> JitCode::make(const std::vector<unsigned char>& code){
+#if UBASIC_JIT
+  auto n= code.size();
+  auto m= ::mmap(P_NIL, n, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+  if(m == MAP_FAILED)
+    return P_NIL;
+  ::memcpy(m, code.data(), n);
+  if(::mprotect(m, n, PROT_READ|PROT_EXEC) != 0){
+    ::munmap(m, n);
+    return P_NIL; }
+  return std::shared_ptr<JitCode>(new JitCode(m, n));
+#else
+  return P_NIL;
+#endif
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+JitCode::~JitCode(){
+#if UBASIC_JIT
+  ::munmap(mem, len);
+#endif
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Jit::Jit(){
+  Value v;
+  tagOff= (char*) &v.tag - (char*) &v;
+  valOff= (char*) &v.u - (char*) &v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::shared_ptr<JitCode> Jit::compile(Compound* c, Basic* b){
+  if(!UBASIC_JIT)
+    return P_NIL;
+
+  vm=b;
+  if(!c->jit(this))
+    return P_NIL;
+
+  // the guards go in front, so a line either runs
+  // natively from the top or not at all.
+  std::vector<unsigned char> body;
+  body.swap(code);
+  int bail= guards.size()*13 + body.size();
+  for(auto& [s,t] : guards){
+    // cmp dword [rdi+tag], t
+    emit({0x83,0xBF});
+    emit32(disp(s,1));
+    emit({t});
+    // jne bail
+    emit({0x0F,0x85});
+    emit32(bail - ((int) code.size()+4)); }
+  s__ccat(code, body);
+  exit(J_BAIL);
+
+  return JitCode::make(code);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Jit::entry(int slot){
+  if(auto i= guards.find(slot); i != guards.end())
+    return i->second;
+  auto t= vm->getSlot(slot).tag;
+  if(t != V_INT && t != V_REAL)
+    return V_NIL;
+  return guards[slot]=t;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Jit::now(int slot){
+  auto i= types.find(slot);
+  return i != types.end() ? i->second : entry(slot);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Jit::disp(int slot, bool tag) const{
+  return slot * (int) sizeof(Value) + (tag ? tagOff : valOff);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::emit(std::initializer_list<int> bs){
+  for(auto b : bs)
+    s__conj(code, (unsigned char) b);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::emit32(int n){
+  for(auto i=0; i < 4; ++i)
+    s__conj(code, (unsigned char) ((unsigned) n >> (8*i)));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::emit64(llong n){
+  emit32((int) n);
+  emit32((int) ((unsigned long long) n >> 32));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::patch(int at){
+  auto n= (int) code.size() - (at+4);
+  for(auto i=0; i < 4; ++i)
+    code[at+i]= (unsigned char) ((unsigned) n >> (8*i));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::exit(int rc){
+  // mov eax, rc; ret
+  emit({0xB8});
+  emit32(rc);
+  emit({0xC3});
+  dead=1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Jit::konst(const Value& v){
+  if(!v.isNum())
+    return false;
+  // mov rax, imm64
+  emit({0x48,0xB8});
+  if(v.isInt())
+    emit64(v.u.n);
+  else{
+    llong bits;
+    ::memcpy(&bits, &v.u.r, sizeof(bits));
+    emit64(bits); }
+  type=v.tag;
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Jit::load(int slot){
+  auto t= now(slot);
+  if(t == V_NIL)
+    return false;
+  // mov rax, [rdi+val]
+  emit({0x48,0x8B,0x87});
+  emit32(disp(slot,0));
+  type=t;
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Jit::store(int slot, cstdstr& name){
+  // a number already in the slot means no object to release.
+  if(name[name.size()-1] == '$' || now(slot) == V_NIL)
+    return false;
+  // mov [rdi+val], rax
+  emit({0x48,0x89,0x87});
+  emit32(disp(slot,0));
+  // mov dword [rdi+tag], type
+  emit({0xC7,0x87});
+  emit32(disp(slot,1));
+  emit32(type);
+  types[slot]=type;
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static bool divides(int op){
+  return op == d::T_DIV || op == T_MOD || op == T_INT_DIV;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Jit::math(int op, int lt, int rt, const Value& divisor){
+  auto ints= lt == V_INT && rt == V_INT;
+  // native code has no way to raise, so only a
+  // known, safe divisor gets through.
+  if(divides(op)){
+    if(!divisor.isNum() || divisor.isZero())
+      return false;
+    if(ints && divisor.getInt() == -1)
+      return false;
+    if(!ints && op != d::T_DIV)
+      return false; }
+
+  if(ints){
+    switch(op){
+    case d::T_PLUS: emit({0x48,0x01,0xC8}); break;
+    case d::T_MINUS: emit({0x48,0x29,0xC8}); break;
+    case d::T_MULT: emit({0x48,0x0F,0xAF,0xC1}); break;
+    case d::T_DIV:
+    case T_INT_DIV:
+      // cqo; idiv rcx
+      emit({0x48,0x99, 0x48,0xF7,0xF9});
+    break;
+    case T_MOD:
+      // cqo; idiv rcx; mov rax, rdx
+      emit({0x48,0x99, 0x48,0xF7,0xF9, 0x48,0x89,0xD0});
+    break;
+    default: return false;
+    }
+    type=V_INT;
+    return true;
+  }
+
+  int k;
+  switch(op){
+  case d::T_PLUS: k=0x58; break;
+  case d::T_MINUS: k=0x5C; break;
+  case d::T_MULT: k=0x59; break;
+  case d::T_DIV: k=0x5E; break;
+  default: return false;
+  }
+  // cvtsi2sd or movq, xmm0 <= rax, xmm1 <= rcx
+  if(lt == V_INT) emit({0xF2,0x48,0x0F,0x2A,0xC0});
+  else emit({0x66,0x48,0x0F,0x6E,0xC0});
+  if(rt == V_INT) emit({0xF2,0x48,0x0F,0x2A,0xC9});
+  else emit({0x66,0x48,0x0F,0x6E,0xC9});
+  // op xmm0, xmm1; movq rax, xmm0
+  emit({0xF2,0x0F,k,0xC1, 0x66,0x48,0x0F,0x7E,0xC0});
+  type=V_REAL;
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::relop(int op, int lt, int rt){
+  if(lt == V_INT && rt == V_INT){
+    int cc=0;
+    switch(op){
+    case d::T_EQ: cc=0x94; break;
+    case T_NOTEQ: cc=0x95; break;
+    case d::T_LT: cc=0x9C; break;
+    case T_LTEQ: cc=0x9E; break;
+    case d::T_GT: cc=0x9F; break;
+    case T_GTEQ: cc=0x9D; break;
+    }
+    // cmp rax, rcx; setcc al
+    emit({0x48,0x39,0xC8, 0x0F,cc,0xC0});
+  }else{
+    if(lt == V_INT) emit({0xF2,0x48,0x0F,0x2A,0xC0});
+    else emit({0x66,0x48,0x0F,0x6E,0xC0});
+    if(rt == V_INT) emit({0xF2,0x48,0x0F,0x2A,0xC9});
+    else emit({0x66,0x48,0x0F,0x6E,0xC9});
+    // unordered sets CF, ZF and PF, so a NaN
+    // must come out false, except for <>.
+    switch(op){
+    case d::T_EQ:
+      // ucomisd xmm0, xmm1; sete al; setnp cl; and al, cl
+      emit({0x66,0x0F,0x2E,0xC1, 0x0F,0x94,0xC0, 0x0F,0x9B,0xC1, 0x20,0xC8});
+    break;
+    case T_NOTEQ:
+      // ucomisd xmm0, xmm1; setne al; setp cl; or al, cl
+      emit({0x66,0x0F,0x2E,0xC1, 0x0F,0x95,0xC0, 0x0F,0x9A,0xC1, 0x08,0xC8});
+    break;
+    case d::T_GT: emit({0x66,0x0F,0x2E,0xC1, 0x0F,0x97,0xC0}); break;
+    case T_GTEQ: emit({0x66,0x0F,0x2E,0xC1, 0x0F,0x93,0xC0}); break;
+    // swap the operands, so that unordered is false.
+    case d::T_LT: emit({0x66,0x0F,0x2E,0xC8, 0x0F,0x97,0xC0}); break;
+    case T_LTEQ: emit({0x66,0x0F,0x2E,0xC8, 0x0F,0x93,0xC0}); break;
+    }
+  }
+  // movzx eax, al
+  emit({0x0F,0xB6,0xC0});
+  type=V_INT;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::neg(){
+  if(type == V_INT)
+    // neg rax
+    emit({0x48,0xF7,0xD8});
+  else
+    // btc rax, 63
+    emit({0x48,0x0F,0xBA,0xF8,0x3F});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Jit::truth(){
+  // drop the sign, -0.0 is zero too.
+  if(type == V_REAL)
+    emit({0x48,0xD1,0xE0});
+  // test rax, rax
+  emit({0x48,0x85,0xC0});
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Jit::merge(const TypeMap& t, bool gone){
+  if(gone)
+    return true;
+  if(dead)
+    return types=t, dead=0, true;
+  auto out= types;
+  for(auto& [s,x] : t){
+    if(now(s) != x) return false;
+    out[s]=x; }
+  for(auto& [s,x] : types){
+    if(t.find(s) == t.end() &&
+       x != guards[s]) return false; }
+  return types=out, true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Compound::jit(Jit* j){
+  for(auto& s : stmts)
+    if(!DCAST(Ast,s)->jit(j)) return false;
+  return j->exit(J_NEXT), true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Assignment::jit(Jit* j){
+  auto v= acast<Var>(lhs);
+  return v &&
+         DCAST(Ast,rhs)->jit(j) && j->store(v->slot(), v->name());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Goto::jit(Jit* j){
+  if(target < 0)
+    return false;
+  return j->exit(target), true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool IfThen::jit(Jit* j){
+  if(!DCAST(Ast,cond)->jit(j))
+    return false;
+  j->truth();
+  auto skip= j->jz();
+  auto before= j->types;
+  if(!DCAST(Ast,then)->jit(j))
+    return false;
+  auto after= j->types;
+  auto gone= j->dead;
+  j->types= before;
+  j->dead=0;
+  if(!elze)
+    j->patch(skip);
+  else{
+    auto out= j->jmp();
+    j->patch(skip);
+    if(!DCAST(Ast,elze)->jit(j))
+      return false;
+    j->patch(out); }
+  return j->merge(after, gone);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool BoolTerm::jit(Jit* j){
+  return terms.size() == 1 && DCAST(Ast,terms[0])->jit(j);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool BoolExpr::jit(Jit* j){
+  return terms.size() == 1 && DCAST(Ast,terms[0])->jit(j);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool RelationOp::jit(Jit* j){
+  if(!DCAST(Ast,lhs)->jit(j))
+    return false;
+  auto lt= j->type;
+  j->push();
+  if(!DCAST(Ast,rhs)->jit(j))
+    return false;
+  auto rt= j->type;
+  j->pop2();
+  return j->relop(tok()->type(), lt, rt), true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool BinOp::jit(Jit* j){
+  auto n= acast<Num>(rhs);
+  if(!DCAST(Ast,lhs)->jit(j))
+    return false;
+  auto lt= j->type;
+  j->push();
+  if(!DCAST(Ast,rhs)->jit(j))
+    return false;
+  auto rt= j->type;
+  j->pop2();
+  return j->math(tok()->type(), lt, rt, n ? n->evalv(P_NIL) : Value());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool UnaryOp::jit(Jit* j){
+  if(!DCAST(Ast,expr)->jit(j))
+    return false;
+  if(tok()->type() == d::T_MINUS)
+    j->neg();
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Num::jit(Jit* j){ return j->konst(num); }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Var::jit(Jit* j){ return j->load(_slot); }
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,120 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "parser.h"
+
+#if defined(__x86_64__) && (defined(__linux__) || defined(__APPLE__))
+#define UBASIC_JIT 1
+#else
+#define UBASIC_JIT 0
+#endif
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace d= czlab::dsl;
+
+// a line runs this many times before it is compiled.
+const int JIT_HOT= 64;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+enum JitExit{
+  // guards failed, nothing was written.
+  J_BAIL= -2,
+  // fall through to the next line.
+  J_NEXT= -1
+  // else, the line position to jump to.
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct JitCode{
+
+  static std::shared_ptr<JitCode> make(const std::vector<unsigned char>&);
+
+  int run(Value* slots) const{ return fn(slots); }
+
+  ~JitCode();
+
+  private:
+
+  JitCode(void* m, size_t n) : mem(m), len(n){
+    fn= (int (*)(Value*)) m; }
+  int (*fn)(Value*);
+  void* mem;
+  size_t len;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Jit{
+
+  typedef std::map<int,int> TypeMap;
+
+  // nil if the line has anything we can't handle.
+  std::shared_ptr<JitCode> compile(Compound*, Basic*);
+
+  // expressions leave the result in rax, reals
+  // as raw bits, and set the type.
+  bool konst(const Value&);
+  bool load(int slot);
+  bool store(int slot, cstdstr& name);
+  bool math(int op, int lt, int rt, const Value& divisor);
+  void relop(int op, int lt, int rt);
+  void neg();
+  void truth();
+  void push(){ emit({0x50}); }
+  // rhs into rcx, lhs back into rax.
+  void pop2(){ emit({0x48,0x89,0xC1, 0x58}); }
+
+  int jz(){ emit({0x0F,0x84}); return rel(); }
+  int jmp(){ emit({0xE9}); return rel(); }
+  void patch(int at);
+  void exit(int code);
+
+  // join the paths of an IF, the other path is current.
+  bool merge(const TypeMap& t, bool gone);
+
+  Jit();
+  ~Jit(){}
+
+  // type of the last expression.
+  int type=V_NIL;
+  // slot => type, as of the code emitted so far.
+  TypeMap types;
+  // the code after an exit is not reached.
+  bool dead=0;
+
+  private:
+
+  int entry(int slot);
+  int now(int slot);
+  int disp(int slot, bool tag) const;
+  int rel(){ emit32(0); return (int) code.size()-4; }
+  void emit(std::initializer_list<int>);
+  void emit32(int);
+  void emit64(llong);
+
+  // slot => type the line expects on entry.
+  TypeMap guards;
+  std::vector<unsigned char> code;
+  int tagOff, valOff;
+  Basic* vm=P_NIL;
+};
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
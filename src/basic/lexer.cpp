@@ -12,6 +12,13 @@
  *
  * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
 
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <array>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "lexer.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -19,42 +26,129 @@ namespace czlab::basic{
 namespace a = czlab::aeon;
 namespace d = czlab::dsl;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-std::map<int, stdstr> TOKENS{
-  {T_ARRAYINDEX, "[]"},
-  {T_FUNCALL, "()"},
-  {T_REM, "REM"},
-  {T_DEF, "DEF"},
-  {T_EOL, "<CR>"},
-  {T_INPUT, "INPUT"},
-  {T_PRINT, "PRINT"},
-  {T_PRINTLN, "PRINTLN"},
-  {T_END, "END"},
-  {T_RUN, "RUN"},
-  {T_LET, "LET"},
-  {T_NOT, "NOT"},
-  {T_ON, "ON"},
-  {T_IF, "IF"},
-  {T_THEN, "THEN"},
-  {T_ELSE, "ELSE"},
-  {T_GOTO, "GOTO"},
-  {T_FOR, "FOR"},
-  {T_TO, "TO"},
-  {T_NEXT, "NEXT"},
-  {T_STEP, "STEP"},
-  {T_READ, "READ"},
-  {T_DATA, "DATA"},
-  {T_GOSUB, "GOSUB"},
-  {T_RETURN, "RETURN"},
-  {T_INT_DIV, "DIV"},
-  {T_MOD, "MOD"},
-  {T_AND, "AND"},
-  {T_OR, "OR"},
-  {T_XOR, "XOR"},
-  {T_DIM, "DIM"},
-  {T_RESTORE, "RESTORE"}
+// keywords, looked up through a perfect hash made at compile time.
+struct Keyword{
+  const char* name;
+  int type;
+};
+constexpr Keyword WORDS[]{
+  {"REM", T_REM},
+  {"DEF", T_DEF},
+  {"INPUT", T_INPUT},
+  {"PRINT", T_PRINT},
+  {"PRINTLN", T_PRINTLN},
+  {"END", T_END},
+  {"RUN", T_RUN},
+  {"LET", T_LET},
+  {"NOT", T_NOT},
+  {"ON", T_ON},
+  {"IF", T_IF},
+  {"THEN", T_THEN},
+  {"ELSE", T_ELSE},
+  {"GOTO", T_GOTO},
+  {"FOR", T_FOR},
+  {"TO", T_TO},
+  {"NEXT", T_NEXT},
+  {"STEP", T_STEP},
+  {"READ", T_READ},
+  {"DATA", T_DATA},
+  {"GOSUB", T_GOSUB},
+  {"RETURN", T_RETURN},
+  {"DIV", T_INT_DIV},
+  {"MOD", T_MOD},
+  {"AND", T_AND},
+  {"OR", T_OR},
+  {"XOR", T_XOR},
+  {"DIM", T_DIM},
+  {"SPARSE", T_SPARSE},
+  {"MAT", T_MAT},
+  {"RESTORE", T_RESTORE}
+};
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+constexpr int length(const char* s){
+  int n=0;
+  while(s[n]) ++n;
+  return n;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// names are upper cased, the source is left as is.
+constexpr char up(char c){ return (c >= 'a' && c <= 'z') ? c-32 : c; }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct KeywordHash{
+  static const int SIZE= 64;
+  // 1 + index into WORDS, 0 if empty.
+  int slots[SIZE]{};
+  int a=0;
+  int b=0;
+  constexpr int hash(const char* s, int n) const{
+    return ((unsigned char)up(s[0]) * a + (unsigned char)up(s[n-1]) * b + n) & (SIZE-1); }
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-auto KEYWORDS= a::map_reflect(TOKENS);
+// try multipliers until no two keywords share a slot.
+constexpr KeywordHash perfect_hash(){
+  for(int a=1; a < KeywordHash::SIZE; ++a)
+    for(int b=0; b < KeywordHash::SIZE; ++b){
+      KeywordHash h;
+      h.a=a; h.b=b;
+      auto ok=true;
+      for(int i=0; ok && i < (int) std::size(WORDS); ++i){
+        auto& x= h.slots[h.hash(WORDS[i].name, length(WORDS[i].name))];
+        if(x) ok=false; else x= i+1; }
+      if(ok) return h; }
+  return KeywordHash{};
+}
+constexpr auto KEYWORDS= perfect_hash();
+static_assert(KEYWORDS.a > 0, "no perfect hash for the keywords");
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the keyword's token type, or 0.
+int keyword(const char* s, int n){
+  if(n < 2 || n > 7) return 0;
+  if(auto i= KEYWORDS.slots[KEYWORDS.hash(s,n)]; i){
+    auto& w= WORDS[i-1];
+    if(length(w.name) != n) return 0;
+    for(int k=0; k < n; ++k)
+      if(up(s[k]) != w.name[k]) return 0;
+    return w.type; }
+  return 0;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+std::map<int, stdstr> TOKENS= []{
+  std::map<int, stdstr> m{
+    {T_ARRAYINDEX, "[]"},
+    {T_FUNCALL, "()"},
+    {T_EOL, "<CR>"}};
+  for(auto& w : WORDS) m[w.type]= w.name;
+  return m; }();
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// character classes, C locale.
+enum{
+  C_SPACE= 1,
+  C_DIGIT= 2,
+  // starts a name.
+  C_ALPHA= 4,
+  // in a name.
+  C_NAME= 8,
+  C_SIGIL= 16,
+  // a one char token.
+  C_OP= 32
+};
+struct CharClass{
+  unsigned char bits[256]{};
+  constexpr CharClass(){
+    for(auto c : " \t\n\v\f\r") bits[(unsigned char)c] |= C_SPACE;
+    for(int c='0'; c <= '9'; ++c) bits[c] |= C_DIGIT | C_NAME;
+    for(int c='A'; c <= 'Z'; ++c){
+      bits[c] |= C_ALPHA | C_NAME;
+      bits[c+32] |= C_ALPHA | C_NAME; }
+    bits['_'] |= C_ALPHA | C_NAME;
+    for(auto c : "$%#!") bits[(unsigned char)c] |= C_SIGIL | C_NAME;
+    for(auto c : "*/+-()^><={};:,'.") bits[(unsigned char)c] |= C_OP;
+    // from the string terminators above.
+    bits[0]=0;
+  }
+  bool is(Tchar c, int k) const{ return bits[(unsigned char)c] & k; }
+};
+constexpr CharClass CLASS;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr typeToString(int t){
   return s__contains(TOKENS, t) ? map__val(TOKENS, t) : ("token#" + N_STR(t)); }
@@ -65,8 +159,12 @@ Lexer::Lexer(const Tchar* src){
   _ctx.cur= getNextToken();
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Lexer::Lexer(const Tchar* src, int len, LexemeVec& out) : _src(src), _len(len){
+  scan(out);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool Lexer::isKeyword(cstdstr& k) const{
-  return s__contains(KEYWORDS, k);
+  return keyword(k.c_str(), k.size()) != 0;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Lexer::skipComment(){
@@ -92,36 +190,202 @@ d::DToken Lexer::string(){
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool filter(Tchar ch, bool first){
-  return first ? (ch == '_' || ::isalpha(ch))
-               : (ch == '_' || ch == '$' || ch == '#' ||
-                  ch == '!' || ch == '%' || ::isalpha(ch) || ::isdigit(ch)); }
+  return CLASS.is(ch, first ? C_ALPHA : C_NAME); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void skip_wspace(d::Context& ctx){
   while(!ctx.eof){
     auto c= peek(ctx);
-    if(c != '\n' && ::isspace(c)) d::advance(ctx); else break; } }
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void checkid(cstdstr& src, d::Addr m){
-  auto cs= src.c_str();
-  auto s= ::strchr(cs, '$');// string var
-  auto i= ::strchr(cs, '%');// integer var
-  auto d= ::strchr(cs, '#');// double var
-  auto f= ::strchr(cs, '!');// float var
-  if((s && *(s+1) != '\0') ||
-     (i && *(i+1) != '\0') ||
-     (f && *(f+1) != '\0') ||
-     (d && *(d+1) != '\0')){
-    E_SYNTAX("Bad name `%s` near %s.", cs, d::pr_addr(m).c_str()); } }
+    if(c != '\n' && CLASS.is(c, C_SPACE)) d::advance(ctx); else break; } }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void checkid(const char* cs, int n, d::Addr m){
+  // a sigil only at the end.
+  for(int i=0; i < n-1; ++i)
+    if(CLASS.is(cs[i], C_SIGIL))
+      E_SYNTAX("Bad name `%s` near %s.",
+               C_STR(a::to_upper(stdstr(cs,n))), d::pr_addr(m).c_str()); }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void to_number(Lexeme& x, const char* cs, int n, d::Addr m){
+  // the source is not NUL terminated, so parse a copy of the digits.
+  char buf[64];
+  char* e= nullptr;
+  auto ok= n < (int)sizeof(buf);
+  if(ok){
+    ::memcpy(buf, cs, n);
+    buf[n]='\0';
+    errno=0;
+    if(x.type == d::T_REAL)
+      x.r= ::strtod(buf, &e);
+    else
+      x.n= ::strtoll(buf, &e, 10);
+    ok= errno == 0 && e == buf+n;
+  }
+  if(!ok)
+    E_SYNTAX("Bad number `%s` near %s.",
+             C_STR(stdstr(cs,n)), d::pr_addr(m).c_str()); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Lexer::id(){
   auto res = d::identifier(_ctx, &filter);
   auto S= a::to_upper(_1(res));
-  auto b= isKeyword(S);
+  auto k= keyword(S.c_str(), S.size());
 
-  if(!b)
-    checkid(S, _2(res));
+  if(!k)
+    checkid(S.c_str(), S.size(), _2(res));
 
-  return d::Token::make(b ? KEYWORDS.at(S) : d::T_IDENT, S, _2(res)); }
+  return d::Token::make(k ? k : d::T_IDENT, S, _2(res)); }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DToken Lexer::token(const Lexeme& x) const{
+  auto m= DMARK(x.line, x.col);
+  switch(x.type){
+    case d::T_INT: return d::Token::make(stdstr(text(x)), m, x.n);
+    case d::T_REAL: return d::Token::make(stdstr(text(x)), m, x.r);
+    case d::T_STRING: return d::Token::make(stdstr(text(x)), m);
+    case T_EOL: return d::Token::make(T_EOL, "<eol>", m);
+    case d::T_EOF: return d::Token::make(d::T_EOF, "<eof>", m);
+    // => and =< are spelt the usual way.
+    case T_GTEQ: return d::Token::make(T_GTEQ, ">=", m);
+    case T_LTEQ: return d::Token::make(T_LTEQ, "<=", m);
+    case T_NOTEQ: return d::Token::make(T_NOTEQ, "<>", m);
+    case d::T_IDENT: return d::Token::make(d::T_IDENT, name(x), m);
+    case d::T_COMMENT: return d::Token::make(d::T_COMMENT, stdstr(text(x)), m);
+  }
+  // keywords are names too.
+  return d::Token::make(x.type,
+                        x.len > 0 && CLASS.is(_src[x.pos], C_ALPHA)
+                        ? name(x) : stdstr(text(x)), m);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Lexer::name(const Lexeme& x) const{
+  stdstr s(_src + x.pos, x.len);
+  for(auto& c : s) c= up(c);
+  return s;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// past a run of blanks and tabs, 16 at a time if we can.
+static int blanks(const char* s, int i, int len){
+#if defined(__SSE2__)
+  auto sp= _mm_set1_epi8(' ');
+  auto tab= _mm_set1_epi8('\t');
+  for(; i+16 <= len; i += 16){
+    auto v= _mm_loadu_si128((const __m128i*)(s+i));
+    auto m= _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v,sp),
+                                           _mm_cmpeq_epi8(v,tab)));
+    if(m != 0xFFFF) return i + __builtin_ctz(~m); }
+#endif
+  while(i < len && (s[i] == ' ' || s[i] == '\t')) ++i;
+  return i;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// same rules as getNextToken, but straight off the buffer.
+void Lexer::scan(LexemeVec& out){
+  static auto ops= []{
+    std::array<int,256> m{};
+    for(auto& x : d::getStrTokens())
+      if(_1(x).size() == 1) m[(unsigned char)_1(x)[0]]= _2(x);
+    return m; }();
+  auto src= _src;
+  int len= _len, i=0, line=1, col=1;
+  // about one token per four bytes of source.
+  out.reserve(len/4 + 1);
+  auto add= [&](int type, int n){
+    auto& x= out.emplace_back();
+    x.type=type; x.line=line; x.col=col;
+    x.pos=i; x.len=n; x.n=0;
+    i += n;
+    col += n;
+    return &x; };
+  auto next= [&](int k){ return k < len ? src[k] : '\0'; };
+
+  while(i < len){
+    auto ch= src[i];
+    if(ch == ' ' || ch == '\t'){
+      auto j= blanks(src, i, len);
+      col += j-i;
+      i=j;
+      continue;
+    }
+    if(ch == '\n' ||
+       (ch == '\r' && next(i+1) == '\n')){
+      add(T_EOL, ch == '\r' ? 2 : 1);
+      ++line; col=1;
+      continue;
+    }
+    if(CLASS.is(ch, C_SPACE)){
+      ++i; ++col;
+      continue;
+    }
+    if(CLASS.is(ch, C_DIGIT) ||
+       (ch == '.' && CLASS.is(next(i+1), C_DIGIT))){
+      auto j=i;
+      auto real=false;
+      for(; j < len && (CLASS.is(src[j], C_DIGIT) || src[j] == '.'); ++j)
+        if(src[j] == '.') real=true;
+      auto m= DMARK(line,col);
+      to_number(*add(real ? d::T_REAL : d::T_INT, j-i), src+i, j-i, m);
+      continue;
+    }
+    if(ch == '"'){
+      auto e= (const char*) ::memchr(src+i+1, '"', len-i-1);
+      auto j= e ? (int)(e-src) : len;
+      auto& x= out.emplace_back();
+      x.type=d::T_STRING; x.line=line; x.col=col;
+      x.pos=i+1; x.len=j-i-1; x.n=0;
+      // strings may run over lines.
+      for(auto k= i; k < j+1 && k < len; ++k)
+        if(src[k] == '\n'){ ++line; col=1; } else ++col;
+      i= j+1 < len ? j+1 : len;
+      continue;
+    }
+    if(CLASS.is(ch, C_ALPHA)){
+      auto j= i;
+      auto sigil= -1;
+      for(; j < len && CLASS.is(src[j], C_NAME); ++j)
+        if(sigil < 0 && CLASS.is(src[j], C_SIGIL)) sigil=j;
+      if(sigil >= 0 && sigil != j-1)
+        checkid(src+i, j-i, DMARK(line,col));
+      if(auto k= sigil < 0 ? keyword(src+i, j-i) : 0; k){
+        add(k, j-i);
+        if(k == T_REM) rest(out, i, col);
+      }else{
+        add(d::T_IDENT, j-i); }
+      continue;
+    }
+    auto nx= next(i+1);
+    if((ch == '=' && nx == '>') || (ch == '>' && nx == '=')){
+      add(T_GTEQ, 2);
+      continue; }
+    if((ch == '=' && nx == '<') || (ch == '<' && nx == '=')){
+      add(T_LTEQ, 2);
+      continue; }
+    if((ch == '>' && nx == '<') || (ch == '<' && nx == '>')){
+      add(T_NOTEQ, 2);
+      continue; }
+    if(CLASS.is(ch, C_OP)){
+      add(ops[(unsigned char)ch], 1);
+      if(ch == '\'') rest(out, i, col);
+    }else{
+      add(d::T_ROGUE, 1); }
+  }
+  add(d::T_EOF, 0);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the rest of a comment line, as one token.
+void Lexer::rest(LexemeVec& out, int& i, int& col){
+  auto src= _src;
+  int len= _len;
+  auto j= blanks(src, i, len);
+  auto e= (const char*) ::memchr(src+j, '\n', len-j);
+  auto k= e ? (int)(e-src) : len;
+  auto end= (k > j && src[k-1] == '\r') ? k-1 : k;
+  col += j-i;
+  i=j;
+  if(end > j){
+    auto line= out.back().line;
+    auto& x= out.emplace_back();
+    x.type=d::T_COMMENT; x.line=line; x.col=col;
+    x.pos=j; x.len=end-j; x.n=0;
+    col += end-j;
+    i=end; }
+}
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken Lexer::getNextToken(){
   auto& tks= d::getStrTokens();
@@ -57,6 +57,8 @@ enum TokenType{
   T_DEF,
   T_XOR,
   T_DIM,
+  T_SPARSE,
+  T_MAT,
   T_RESTORE,
   T_PROGRAM,
 
@@ -64,6 +66,19 @@ enum TokenType{
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr typeToString(int type);
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a token in the flat buffer, the text is [pos, pos+len) of the
+// (src, len) the lexer was given, numbers are parsed already.
+struct Lexeme{
+  int type;
+  int line;
+  int col;
+  int pos;
+  int len;
+  union{ llong n; double r; };
+};
+typedef std::vector<Lexeme> LexemeVec;
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Lexer : public d::IScanner{
 
@@ -77,11 +92,30 @@ struct Lexer : public d::IScanner{
   virtual d::DToken string();
 
   Lexer(const Tchar* src);
+  // lex src[0,len) into out, no tokens are made. The source
+  // needn't end in a nul, and must outlive the lexer.
+  Lexer(const Tchar* src, int len, LexemeVec& out);
   virtual ~Lexer(){}
 
+  // make the token for a lexeme.
+  d::DToken token(const Lexeme&) const;
+  std::string_view text(const Lexeme& x) const{
+    return std::string_view(_src + x.pos, x.len); }
+  // the text of a name or keyword, upper cased.
+  stdstr name(const Lexeme&) const;
+  // the char after the lexeme, strings end past the quote.
+  Tchar after(const Lexeme& x) const{
+    auto k= x.pos + x.len + (x.type == d::T_STRING ? 1 : 0);
+    return k < _len ? _src[k] : '\0'; }
+
   private:
 
+  void scan(LexemeVec&);
+  void rest(LexemeVec&, int& pos, int& col);
   d::Context _ctx;
+  // not ours, it's read only.
+  const Tchar* _src=P_NIL;
+  int _len=0;
 };
 
 
@@ -13,18 +13,72 @@
  * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
 
 #include <iostream>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "types.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::basic{
 using namespace czlab::aeon;
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the program file, mapped read only so it is never copied and
+// the pages are shared by every process running it.
+struct Source{
+
+  Source(const char* path){
+    auto fd= ::open(path, O_RDONLY);
+    struct stat st;
+    if(fd >= 0 && ::fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0){
+      // the lexer works in int offsets.
+      if(st.st_size > INT_MAX){
+        ::close(fd);
+        RAISE(d::BadArg, "Source too large, %s", path); }
+      auto p= ::mmap(P_NIL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(p != MAP_FAILED){
+        ::madvise(p, st.st_size, MADV_SEQUENTIAL);
+        data= (const char*) p;
+        len= st.st_size; } }
+    if(fd >= 0) ::close(fd);
+    // pipes and empty files are read the old way.
+    if(!data){
+      copy= read_file(path);
+      if(copy.size() > INT_MAX)
+        RAISE(d::BadArg, "Source too large, %s", path);
+      len= copy.size(); }
+  }
+
+  ~Source(){ if(data) ::munmap((void*) data, len); }
+
+  Source(const Source&)=delete;
+  Source& operator=(const Source&)=delete;
+
+  const char* chars() const{ return data ? data : copy.data(); }
+  int size() const{ return (int) len; }
+
+  private:
+
+  const char* data=P_NIL;
+  stdstr copy;
+  size_t len=0;
+};
+
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int usage(int argc, char* argv[]){
-  std::cout << stdstr("usage: ")+ argv[0] + " <input-file>" << "\n";
+  std::cout << stdstr("usage: ")+ argv[0] + " [options] <input-file>" << "\n";
   std::cout << "input-file: BASIC file" << "\n";
+  std::cout << "options:" << "\n";
+  std::cout << "  --vm  run on the bytecode vm" << "\n";
+  std::cout << "  --no-fold  skip constant folding" << "\n";
+  std::cout << "  --no-jit  never compile hot lines to native code" << "\n";
+  std::cout << "  --emit-cpp  print the program as C++, don't run it" << "\n";
+  std::cout << "  --no-par  parse on one thread" << "\n";
   std::cout << "\n";
   return 1;
 }
@@ -34,11 +88,34 @@ int main(int argc, char* argv[]) {
   using namespace czlab::basic;
   namespace a=czlab::aeon;
 
-  if(argc<2)
+  int opts=O_FOLD|O_JIT|O_PAR;
+  int i=1;
+  for(; i<argc && ::strncmp(argv[i], "--", 2)==0; ++i){
+    stdstr o {argv[i]};
+    if(o == "--vm")
+      opts |= O_VM;
+    else
+    if(o == "--no-fold")
+      opts &= ~O_FOLD;
+    else
+    if(o == "--no-jit")
+      opts &= ~O_JIT;
+    else
+    if(o == "--emit-cpp")
+      opts |= O_CPP;
+    else
+    if(o == "--no-par")
+      opts &= ~O_PAR;
+    else
+      return usage(argc, argv);
+  }
+
+  if(i != argc-1)
     return usage(argc, argv);
 
   try{
-    Basic(a::read_file(argv[1]).c_str()).interpret();
+    Source src(argv[i]);
+    Basic(src.chars(), src.size(), opts).interpret();
     //std::cout << "done." << "\n";
   }catch(const a::Error& e){
     std::cout << e.what() << "\n";
@@ -0,0 +1,158 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "mat.h"
+#include "simd.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// a dense copy of the operand, row major.
+struct Mat{
+  std::vector<double> m;
+  int rows=0;
+  int cols=0;
+  bool ints=1;
+  void shape(int r, int c){ rows=r; cols=c; m.assign(r*c, 0); }
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static BArray* matrix(const Value& v, d::Addr _A){
+  auto a= vcast<BArray>(v, _A);
+  if(a->elemType() == AT_STR || a->rank() > 2)
+    E_SEMANTIC("MAT wanted a numeric vector or matrix near %s.",
+               C_STR(d::pr_addr(_A)));
+  return a;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static int rows(BArray* a){ return a->extent(0)-1; }
+static int cols(BArray* a){ return a->rank() > 1 ? a->extent(1)-1 : 1; }
+static int pos(BArray* a, int r, int c){
+  return a->rank() > 1 ? a->offset(r,c) : a->offset(r); }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static Mat load(BArray* a){
+  Mat res;
+  res.shape(rows(a), cols(a));
+  auto p= res.m.data();
+  for(int r=1; r <= res.rows; ++r)
+    for(int c=1; c <= res.cols; ++c){
+      auto v= a->get(pos(a,r,c));
+      if(!v.isInt()) res.ints=0;
+      *p++ = v.getFloat(); }
+  return res;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static void store(BArray* a, const Mat& res, d::Addr _A){
+  if(rows(a) != res.rows || cols(a) != res.cols)
+    E_SEMANTIC("MAT result %dx%d doesn't fit %dx%d near %s.",
+               res.rows, res.cols, rows(a), cols(a), C_STR(d::pr_addr(_A)));
+  auto p= res.m.data();
+  for(int r=1; r <= res.rows; ++r)
+    for(int c=1; c <= res.cols; ++c, ++p)
+      a->set(pos(a,r,c),
+             res.ints ? Value::make((llong) *p) : Value::make(*p));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static void same(const Mat& x, const Mat& y, d::Addr _A){
+  if(x.rows != y.rows || x.cols != y.cols)
+    E_SEMANTIC("MAT shapes %dx%d and %dx%d differ near %s.",
+               x.rows, x.cols, y.rows, y.cols, C_STR(d::pr_addr(_A)));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int mat_arity(int op){
+  switch(op){
+    case MAT_ADD: case MAT_SUB:
+    case MAT_MUL: case MAT_SCALE: return 2;
+    case MAT_COPY: case MAT_TRN: return 1;
+  }
+  return 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void mat_run(int op, const Value& dst,
+             const Value& x, const Value& y, d::Addr _A){
+  auto out= matrix(dst,_A);
+  Mat res;
+  switch(op){
+    case MAT_ZER:
+    case MAT_CON:
+    case MAT_IDN:
+      res.shape(rows(out), cols(out));
+      if(op == MAT_CON)
+        res.m.assign(res.m.size(), 1);
+      if(op == MAT_IDN){
+        if(res.rows != res.cols || out->rank() != 2)
+          E_SEMANTIC("IDN wanted a square matrix near %s.",
+                     C_STR(d::pr_addr(_A)));
+        for(int i=0; i < res.rows; ++i) res.m[i*res.cols+i]=1; }
+    break;
+    case MAT_COPY:
+      res= load(matrix(x,_A));
+    break;
+    case MAT_TRN: {
+      auto a= load(matrix(x,_A));
+      res.shape(a.cols, a.rows);
+      res.ints= a.ints;
+      for(int r=0; r < a.rows; ++r)
+        for(int c=0; c < a.cols; ++c)
+          res.m[c*a.rows+r] = a.m[r*a.cols+c]; }
+    break;
+    case MAT_ADD:
+    case MAT_SUB: {
+      auto a= load(matrix(x,_A));
+      auto b= load(matrix(y,_A));
+      same(a,b,_A);
+      res.shape(a.rows, a.cols);
+      res.ints= a.ints && b.ints;
+      simd::axpby(res.m.data(), a.m.data(), b.m.data(),
+            op == MAT_SUB ? -1 : 1, (int) res.m.size()); }
+    break;
+    case MAT_SCALE: {
+      auto& k= vnum(x,_A);
+      res= load(matrix(y,_A));
+      res.ints= res.ints && k.isInt();
+      auto s= k.getFloat();
+      for(auto& v : res.m) v *= s; }
+    break;
+    case MAT_MUL: {
+      auto a= load(matrix(x,_A));
+      auto b= load(matrix(y,_A));
+      if(a.cols != b.rows)
+        E_SEMANTIC("MAT can't multiply %dx%d by %dx%d near %s.",
+                   a.rows, a.cols, b.rows, b.cols, C_STR(d::pr_addr(_A)));
+      res.shape(a.rows, b.cols);
+      res.ints= a.ints && b.ints;
+      // i-k-j keeps the inner loop on contiguous rows.
+      for(int i=0; i < a.rows; ++i){
+        auto row= res.m.data() + i*b.cols;
+        for(int k=0; k < a.cols; ++k)
+          simd::axpy(row, b.m.data() + k*b.cols, a.m[i*a.cols+k], b.cols); } }
+    break;
+  }
+  store(out,res,_A);
+}
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
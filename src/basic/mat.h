@@ -0,0 +1,49 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "types.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+enum MatOp{
+  MAT_COPY,    // A = B
+  MAT_ADD,     // A = B + C
+  MAT_SUB,     // A = B - C
+  MAT_MUL,     // A = B * C
+  MAT_SCALE,   // A = (k) * B
+  MAT_TRN,     // A = TRN(B)
+  MAT_ZER,
+  MAT_CON,
+  MAT_IDN
+};
+
+// operands taken by a MAT op.
+int mat_arity(int op);
+
+// run a MAT op, the target must be DIMed to the shape of the result.
+// like Dartmouth, DIM A(m,n) is a m by n matrix from A(1,1),
+// a one dimension array is a column.
+void mat_run(int op, const Value& dst,
+             const Value& x, const Value& y, d::Addr);
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -13,6 +13,10 @@
  * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
 
 #include "parser.h"
+#include "jit.h"
+#include <array>
+#include <thread>
+#include <exception>
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::basic{
@@ -84,6 +88,15 @@ d::DValue Compound::eval(d::IEvaluator* e){
   auto len= stmts.size();
   auto pos= _e->poffset();
   //std::cout << "line = " << line() << "\n";
+  if(pos == 0 && _e->jitOn()){
+    if(!native && hits >= 0 && ++hits > JIT_HOT){
+      native= Jit().compile(this, _e);
+      // never try again.
+      if(!native) hits= -1; }
+    if(native){
+      auto rc= native->run(_e->slotBase());
+      if(rc >= 0) _e->jumpPos(rc);
+      if(rc != J_BAIL) return DVAL_NIL; } }
   for(; pos < len; ++pos){
     auto ps= DCAST(Ast,stmts[pos]);
     auto res= ps->eval(e);
@@ -108,10 +121,9 @@ OnXXX::OnXXX(d::DToken t, d::DAst v, d::TokenVec& vs) : Ast(t){
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue OnXXX::eval(d::IEvaluator* e){
   auto _e= s__cast(Basic,e);
-  auto v= var->eval(e);
+  auto v= DCAST(Ast,var)->evalv(e);
   auto _A=tok()->addr();
-  auto n= vcast<d::Number>(v,_A);
-  auto x= n->getInt();
+  auto x= vnum(v,_A).getInt();
   auto tz= targets.size();
   auto res= DVAL_NIL;
   //if x is 1, it jumps to the first line in the list;
@@ -119,31 +131,40 @@ d::DValue OnXXX::eval(d::IEvaluator* e){
   if(x > 0 && x <= tz){
     // get the selected target
     auto t= tok()->type();
-    x= targets[x-1];
+    x= posns[x-1];
     if(t == T_GOTO)
-      _e->jump(x);
+      _e->jumpPos(x);
     else
     if(t== T_GOSUB)
-      _e->jumpSub(x, line(), offset());
+      _e->jumpSubPos(x, offset());
     res=NUMBER_VAL(0);
   }
 
   return res;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void OnXXX::visit(d::IAnalyzer* a){
+  auto _a= s__cast(Basic,a);
+  auto sub= tok()->type() == T_GOSUB;
+  var->visit(a);
+  posns.clear();
+  for(auto n : targets)
+    s__conj(posns, _a->resolve(n, sub, tok()->addr()));
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue ForNext::eval(d::IEvaluator* e){
   auto _e = s__cast(Basic,e);
-  _e->jumpFor(_e->getForLoop(_e->pc(),offset()));
+  _e->jumpFor(info);
   return NUMBER_VAL(0);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void ForNext::visit(d::IAnalyzer* a){
   auto _e = s__cast(Basic,a);
   if(!var)
-    _e->xrefForNext(line(), offset());
+    info= _e->xrefForNext(line(), offset());
   else{
     var->visit(a);
-    _e->xrefForNext(PNAME(Var,var), line(), offset()); }
+    info= _e->xrefForNext(PNAME(Var,var), line(), offset()); }
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr ForNext::pr_str() const{
@@ -156,35 +177,46 @@ stdstr ForNext::pr_str() const{
 d::DValue ForLoop::eval(d::IEvaluator* e){
   auto _e = s__cast(Basic,e);
   auto _A= tok()->addr();
-  auto P = _e->pc();
+  auto& f= info;
+  auto& t= f->term;
+  auto& s= f->step;
   bool quit=1;
-  auto f= _e->getForLoop(P,offset());
-  //calc step and term
-  auto _t= term->eval(e);
-  auto _s= step->eval(e);
-  auto s= vcast<d::Number>(_s,_A);
-  auto t= vcast<d::Number>(_t,_A);
-  auto i=t;
+  auto n= DCAST(Var,var)->slot();
   auto z= 0.0;
-  // first invoke
+  // first invoke, TO and STEP are evaluated just once
   if(!f->init){
-    f->init = init->eval(e);
-    i= vcast<d::Number>(f->init,_A);
-    z= i->getFloat();
-    e->setValue(f->var, f->init);
+    t= DCAST(Ast,term)->evalv(e);
+    s= DCAST(Ast,step)->evalv(e);
+    vnum(s,_A);
+    vnum(t,_A);
+    f->init = DCAST(Ast,init)->evalv(e);
+    z= vnum(f->init,_A).getFloat();
+    _e->setSlot(n, f->init);
+    f->ints= f->init.isInt() && t.isInt() && s.isInt();
+  }else
+  if(auto& v= _e->refSlot(n); f->ints && v.isInt()){
+    //integer counter, bump it in place
+    auto i= v.getInt() + s.getInt();
+    v= Value::make(i);
+    if(s.isPos())
+      quit = i > t.getInt();
+    if(s.isNeg())
+      quit = i < t.getInt();
+    if(quit)
+      _e->endFor(f);
+    return quit ? NUMBER_VAL(0) : DVAL_NIL;
   }else{
-    auto _v= e->getValue(f->var);
-    auto v= vcast<d::Number>(_v,_A);
+    vnum(v,_A);
     //do var +/- step
-    z = v->getFloat() + s->getFloat();
+    z = v.getFloat() + s.getFloat();
     //update the var
-    e->setValue(f->var,
-                v->isInt() ? NUMBER_VAL((llong) z) : NUMBER_VAL(z)); }
+    _e->setSlot(n,
+                v.isInt() ? Value::make((llong) z) : Value::make(z)); }
   //test for loop termination
-  if(s->isPos())
-    quit = z > t->getFloat();
-  if(s->isNeg())
-    quit = z < t->getFloat();
+  if(s.isPos())
+    quit = z > t.getFloat();
+  if(s.isNeg())
+    quit = z < t.getFloat();
 
   if(quit)
     _e->endFor(f);
@@ -199,7 +231,8 @@ void ForLoop::visit(d::IAnalyzer* a){
   init->visit(a);
   term->visit(a);
   step->visit(a);
-  _a->addForLoop(ForLoopInfo::make(vn, line(), offset()));
+  info= ForLoopInfo::make(vn, line(), offset());
+  _a->addForLoop(info);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr ForLoop::pr_str() const{
@@ -214,9 +247,8 @@ stdstr ForLoop::pr_str() const{
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue IfThen::eval(d::IEvaluator* e){
-  auto c= cond->eval(e);
-  auto n= vcast<d::Number>(c,tok()->addr());
-  return !n->isZero() ? then->eval(e) : (elze ? elze->eval(e) : DVAL_NIL); }
+  auto c= DCAST(Ast,cond)->evalv(e);
+  return !vnum(c,tok()->addr()).isZero() ? then->eval(e) : (elze ? elze->eval(e) : DVAL_NIL); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr IfThen::pr_str() const{
   stdstr buf;
@@ -245,7 +277,7 @@ void Data::visit(d::IAnalyzer* a){
   auto _a = s__cast(Basic,a);
   for(auto& x : data){
     x->visit(a);
-    _a->addData(x->eval(_a)); }
+    _a->addData(DCAST(Ast,x)->evalv(_a)); }
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Data::pr_str() const{
@@ -263,50 +295,57 @@ d::DValue GoSubReturn::eval(d::IEvaluator* e){
 d::DValue GoSub::eval(d::IEvaluator* e){
   //std::cout << "Jumping to subroutine: " << "\n";
   auto _e= s__cast(Basic,e);
-  auto res= expr->eval(e);
-  auto des= vcast<d::Number>(res,tok()->addr());
+  if(target >= 0)
+    return _e->jumpSubPos(target, offset()), NUMBER_VAL(0);
+  auto res= DCAST(Ast,expr)->evalv(e);
+  auto& des= vnum(res,tok()->addr());
   //std::cout << "Jumping to subroutine: " << des << "\n";
-  return _e->jumpSub(des->getInt(), line(), offset()), NUMBER_VAL(0); }
+  return _e->jumpSub(des.getInt(), line(), offset()), NUMBER_VAL(0); }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void GoSub::visit(d::IAnalyzer* a){
+  expr->visit(a);
+  if(auto n= acast<Num>(expr); n &&
+     n->tok()->type() == d::T_INT)
+    target= s__cast(Basic,a)->resolve(n->tok()->getInt(), true, tok()->addr());
+}
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr GoSub::pr_str() const{
   return tok()->getStr() + " " + PRN(expr); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Goto::eval(d::IEvaluator* e){
   auto _e= s__cast(Basic,e);
-  auto res= expr->eval(e);
-  auto line= vcast<d::Number>(res,tok()->addr());
+  if(target >= 0)
+    return _e->jumpPos(target), NUMBER_VAL(0);
+  auto res= DCAST(Ast,expr)->evalv(e);
+  auto& line= vnum(res,tok()->addr());
   //std::cout << "Jumping to line: " << line << "\n";
-  return _e->jump(line->getInt()), NUMBER_VAL(0);
+  return _e->jump(line.getInt()), NUMBER_VAL(0);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Goto::visit(d::IAnalyzer* a){
+  expr->visit(a);
+  if(auto n= acast<Num>(expr); n &&
+     n->tok()->type() == d::T_INT)
+    target= s__cast(Basic,a)->resolve(n->tok()->getInt(), false, tok()->addr());
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Goto::pr_str() const{
   return tok()->getStr() + " " + PRN(expr); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue FuncCall::eval(d::IEvaluator* e){
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value FuncCall::evalv(d::IEvaluator* e){
   auto pvar= DCAST(Var,fn);
-  auto _A=tok()->addr();
-  auto n= pvar->name();
-  auto f= e->getValue(n);
-
-  if(!f)
-    RAISE(d::NoSuchVar, "Unknown function/array: %s", n.c_str());
-
-  auto fv = vcast<LibFunc>(f);
-  auto fd = vcast<Lambda>(f);
-  auto fa = vcast<BArray>(f);
-
-  if(E_NIL(fa) &&
-     E_NIL(fv) && E_NIL(fd))
-    expected("Array var or function", f, _A);
-
-  d::ValVec pms;
-  for(auto& a : args)
-    s__conj(pms, a->eval(e));
-
-  d::VSlice _args(pms);
-  auto ff = X_NIL(fd) ? (Function*) fd : (Function*) fv;
-
-  return fa ? fa->get(_args) : (pms.empty() ? ff->invoke(e) : ff->invoke(e,_args)); }
+  auto& f= s__cast(Basic,e)->getSlot(pvar->slot());
+  auto n= (int) args.size();
+  Value buf[ARGS_INLINE];
+  ValueVec more;
+  auto pms= n <= ARGS_INLINE ? buf : (more.resize(n), more.data());
+  for(auto i=0; i < n; ++i)
+    pms[i]= DCAST(Ast,args[i])->evalv(e);
+  return site.call(e, f, ValSlice(pms, pms+n), pvar->name(), tok()->addr()); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr FuncCall::pr_str() const{
   stdstr pms, buf { PRN(fn) };
@@ -316,25 +355,94 @@ stdstr FuncCall::pr_str() const{
   return buf + pms + ")";
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void FuncCall::store(d::IEvaluator* e, const Value& res, d::Addr _A){
+  ValueVec out;
+  for(auto& x : args)
+    s__conj(out, DCAST(Ast,x)->evalv(e));
+  auto vn= PNAME(Var,fn);
+  auto& vv= s__cast(Basic,e)->getSlot(DCAST(Var,fn)->slot());
+  auto arr= vcast<BArray>(vv,_A);
+  ensure_data_type(vn,res);
+  arr->set(ValSlice(out), res);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<int N>
+BArray* ArrayRef<N>::array(d::IEvaluator* e) const{
+  auto& vv= s__cast(Basic,e)->getSlot(DCAST(Var,fn)->slot());
+  auto arr= vcast<BArray>(vv);
+  // anything else takes the general path, errors and all.
+  return (X_NIL(arr) && arr->rank() == N) ? arr : P_NIL;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<int N>
+int ArrayRef<N>::offset(d::IEvaluator* e, BArray* arr){
+  Value v[N];
+  llong x[N];
+  for(auto i=0; i < N; ++i)
+    v[i]= DCAST(Ast,args[i])->evalv(e);
+  for(auto i=0; i < N; ++i){
+    if(!v[i].isInt())
+      E_SEMANTIC("Array index expected Int, got %s", C_STR(v[i].pr_str(1)));
+    x[i]= v[i].u.n; }
+  if constexpr(N == 1)
+    return arr->offset(x[0]);
+  else
+  if constexpr(N == 2)
+    return arr->offset(x[0], x[1]);
+  else
+    return arr->offset(x[0], x[1], x[2]);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<int N>
+Value ArrayRef<N>::evalv(d::IEvaluator* e){
+  auto arr= array(e);
+  return arr ? arr->get(offset(e,arr)) : FuncCall::evalv(e);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template<int N>
+void ArrayRef<N>::store(d::IEvaluator* e, const Value& res, d::Addr _A){
+  auto arr= array(e);
+  if(!arr)
+    return FuncCall::store(e, res, _A);
+  auto pos= offset(e,arr);
+  ensure_data_type(PNAME(Var,fn),res);
+  arr->set(pos, res);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template struct ArrayRef<1>;
+template struct ArrayRef<2>;
+template struct ArrayRef<3>;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue BoolTerm::eval(d::IEvaluator* e){
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BoolTerm::visit(d::IAnalyzer* a){
+  for(auto& x : terms)
+    x->visit(a);
+  // one term is passed through as is.
+  _vtype= terms.size() == 1 ? DCAST(Ast,terms[0])->vtype() : VT_NUM;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BoolTerm::evalv(d::IEvaluator* e){
   auto _A=tok()->addr();
   auto z=terms.size();
   auto i=0;
   auto ti= terms[i];
-  auto lhs = ti->eval(e);
-  auto res= !vcast<d::Number>(lhs,_A)->isZero();
+  auto lhs = DCAST(Ast,ti)->evalv(e);
+  auto res= !vnum(lhs,_A).isZero();
   //just one term?
   if(z==1) return lhs;
-  if(!res) return FALSE_VAL();
+  if(!res) return Value::make(0);
   //
   ++i;
   while(i < z){
     auto ti= terms[i];
-    auto _t = ti->eval(e);
-    auto rhs = !vcast<d::Number>(_t,_A)->isZero();
+    auto _t = DCAST(Ast,ti)->evalv(e);
+    auto rhs = !vnum(_t,_A).isZero();
     res= (res && rhs);
-    if (res) break; else ++i; }
-  return res ? TRUE_VAL() : FALSE_VAL();
+    if (!res) break; else ++i; }
+  return Value::make(res ? 1 : 0);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr BoolTerm::pr_str() const{
@@ -357,29 +465,39 @@ stdstr BoolExpr::pr_str() const{
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue BoolExpr::eval(d::IEvaluator* e){
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BoolExpr::visit(d::IAnalyzer* a){
+  for(auto& x : terms)
+    x->visit(a);
+  _vtype= terms.size() == 1 ? DCAST(Ast,terms[0])->vtype() : VT_NUM;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BoolExpr::evalv(d::IEvaluator* e){
   auto _A=tok()->addr();
   int z1= terms.size();
   int t1= ops.size();
   auto i=0;
   auto ti= terms[i];
-  auto lhs= ti->eval(e);
-  auto res= !vcast<d::Number>(lhs,_A)->isZero();
+  auto lhs= DCAST(Ast,ti)->evalv(e);
   if(z1==1) { return lhs; }
+  auto res= !vnum(lhs,_A).isZero();
   while(i < t1){
     auto t= ops[i];
     if(t->type() == T_OR && res) {
       break;
     }
     auto ti=terms[i+1];
-    auto _r= ti->eval(e);
-    auto rhs= !vcast<d::Number>(_r,_A)->isZero();
+    auto _r= DCAST(Ast,ti)->evalv(e);
+    auto rhs= !vnum(_r,_A).isZero();
     if(t->type() == T_XOR)
       res= (res != rhs);
     else
     if(rhs){ res=true; }
     ++i;
   }
-  return res ? TRUE_VAL() : FALSE_VAL();
+  return Value::make(res ? 1 : 0);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr RelationOp::pr_str() const{
@@ -392,53 +510,22 @@ stdstr RelationOp::pr_str() const{
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue RelationOp::eval(d::IEvaluator* e){
-  auto _A= tok()->addr();
-  auto k= tok()->type();
-  auto x = lhs->eval(e);
-  auto y = rhs->eval(e);
-  auto s1= vcast<d::String>(x);
-  auto s2= vcast<d::String>(y);
-  if(s1 && s2){
-    switch(k){
-    case d::T_EQ: return NUMBER_VAL(s1->impl()==s2->impl()?1:0);
-    case T_NOTEQ: return NUMBER_VAL(s1->impl()==s2->impl()?0:1);
-    }
-    E_SEMANTIC("Bad op on strings near %s", d::pr_addr(_A).c_str()); }
-  // fall through to numbers
-  auto xn= vcast<d::Number>(x,_A);
-  auto yn= vcast<d::Number>(y,_A);
-  auto ints = xn->isInt() && yn->isInt();
-  bool b=0;
-
-  switch(k){
-  case T_NOTEQ:
-    b= x->equals(y) ? 0 : 1;
-  break;
-  case d::T_EQ:
-    b= x->equals(y) ? 1 : 0;
-  break;
-  case T_GTEQ:
-    b= ints
-         ? xn->getInt() >= yn->getInt()
-         : xn->getFloat() >= yn->getFloat();
-  break;
-  case T_LTEQ:
-    b= ints
-         ? xn->getInt() <= yn->getInt()
-         : xn->getFloat() <= yn->getFloat();
-  break;
-  case d::T_GT:
-    b= ints
-         ? xn->getInt() > yn->getInt()
-         : xn->getFloat() > yn->getFloat();
-  break;
-  case d::T_LT:
-  b= ints
-       ? xn->getInt() < yn->getInt()
-       : xn->getFloat() < yn->getFloat();
-  break;
-  }
-  return b ? TRUE_VAL() : FALSE_VAL();
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value RelationOp::evalv(d::IEvaluator* e){
+  auto x = DCAST(Ast,lhs)->evalv(e);
+  auto y = DCAST(Ast,rhs)->evalv(e);
+  return typed ? op_relnum(x, tok()->type(), y)
+               : op_relation(x, tok()->type(), y, tok()->addr());
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void RelationOp::visit(d::IAnalyzer* a){
+  lhs->visit(a);
+  rhs->visit(a);
+  typed= DCAST(Ast,lhs)->vtype() == VT_NUM &&
+         DCAST(Ast,rhs)->vtype() == VT_NUM;
+  _vtype=VT_NUM;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Read::pr_str() const{
@@ -457,22 +544,10 @@ d::DValue Read::eval(d::IEvaluator* e){
     auto res= _e->readData();
     if(!res)
       E_SEMANTIC("Can't read data near %s", d::pr_addr(_A).c_str());
-    stdstr pv;
     if(z==T_ARRAYINDEX){
-      auto fc= DCAST(FuncCall,v);
-      d::ValVec out;
-      auto& args= fc->funcArgs();
-      for(auto& x : args)
-        s__conj(out, x->eval(e));
-      auto fcn=fc->funcName();
-      pv=PNAME(Var,fcn);
-      auto vv= e->getValue(pv);
-      auto arr= vcast<BArray>(vv,_A);
-      ensure_data_type(pv,res);
-      arr->set(d::VSlice(out), res);
+      DCAST(FuncCall,v)->store(e, res, _A);
     }else{
-      pv= PNAME(Var,v);
-      e->setValue(pv, res); } }
+      _e->setSlot(DCAST(Var,v)->slot(), res); } }
   return DVAL_NIL;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -481,29 +556,38 @@ stdstr NotFactor::pr_str() const{
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue NotFactor::eval(d::IEvaluator* e){
-  auto res= expr->eval(e);
-  auto i= vcast<d::Number>(res,tok()->addr());
-  return i->isZero() ? TRUE_VAL() : FALSE_VAL();
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value NotFactor::evalv(d::IEvaluator* e){
+  auto res= DCAST(Ast,expr)->evalv(e);
+  return Value::make(vnum(res,tok()->addr()).isZero() ? 1 : 0);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue BinOp::eval(d::IEvaluator* e){
-  auto _A= tok()->addr();
-  auto t= tok()->type();
-  auto lf= lhs->eval(e);
-  auto rt= rhs->eval(e);
-  auto s1= vcast<d::String>(lf);
-  auto s2= vcast<d::String>(rt);
-  auto n1= vcast<d::Number>(lf);
-  auto n2= vcast<d::Number>(rt);
-
-  if(n1 && n2)
-    return op_math(lf, t, rt);
-
-  if(s1 && s2 && t==d::T_PLUS)
-    return STRING_VAL(s1->impl() + s2->impl());
-
-  E_SEMANTIC("Bad op `%s` near %s",
-               typeToString(t).c_str(), d::pr_addr(_A).c_str());
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BinOp::evalv(d::IEvaluator* e){
+  auto lf= DCAST(Ast,lhs)->evalv(e);
+  auto rt= DCAST(Ast,rhs)->evalv(e);
+  return typed ? op_math(lf, tok()->type(), rt)
+               : op_binary(lf, tok()->type(), rt, tok()->addr());
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BinOp::visit(d::IAnalyzer* a){
+  lhs->visit(a);
+  rhs->visit(a);
+  auto l= DCAST(Ast,lhs)->vtype();
+  auto r= DCAST(Ast,rhs)->vtype();
+  // mixed operands fail at runtime, so one
+  // known side decides the result.
+  typed= l == VT_NUM && r == VT_NUM;
+  if(l == VT_NUM || r == VT_NUM)
+    _vtype=VT_NUM;
+  else
+  if(l == VT_STR || r == VT_STR)
+    _vtype=VT_STR;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr BinOp::pr_str() const{
@@ -522,34 +606,45 @@ d::DValue Defun::eval(d::IEvaluator* e){
 void Defun::visit(d::IAnalyzer* a){
   var->visit(a);
   StrVec vs;
+  IntVec ss;
 
   for(auto& p : params){
     p->visit(a);
+    s__conj(ss, DCAST(Var,p)->slot());
     s__conj(vs, PNAME(Var,p)); }
 
   auto vn = PNAME(Var,var);
   auto _a = s__cast(Basic, a);
   body->visit(a);
-  _a->addLambda(Lambda::make(vn, vs, body));
+  _a->addLambda(Lambda::make(vn, vs, ss, body));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Num::eval(d::IEvaluator* e){
-  if(tok()->type() == d::T_INT) {
-    return NUMBER_VAL(tok()->getInt()); }
-  else{
-    return NUMBER_VAL(tok()->getFloat()); }
+  return num.box();
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Num::evalv(d::IEvaluator*){ return num; }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr String::pr_str() const{
   return "\"" + tok()->pr_str() + "\"";
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue String::eval(d::IEvaluator*){
-  return STRING_VAL(tok()->getStr());
+  return str.obj();
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value String::evalv(d::IEvaluator*){ return str; }
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Var::eval(d::IEvaluator* e){
-  return e->getValue(tok()->getStr());
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Var::evalv(d::IEvaluator* e){
+  return s__cast(Basic,e)->getSlot(_slot);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Var::visit(d::IAnalyzer* a){
+  _slot= s__cast(Basic,a)->slot(name());
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr UnaryOp::pr_str() const{
@@ -557,13 +652,17 @@ stdstr UnaryOp::pr_str() const{
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue UnaryOp::eval(d::IEvaluator* e){
-  auto res = expr->eval(e);
-  auto n = vcast<d::Number>(res,tok()->addr());
+  return evalv(e).box();
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value UnaryOp::evalv(d::IEvaluator* e){
+  auto res = DCAST(Ast,expr)->evalv(e);
+  auto& n = vnum(res,tok()->addr());
   if(tok()->type() == d::T_MINUS){
-    if(n->isInt())
-      res = NUMBER_VAL(- n->getInt());
+    if(n.isInt())
+      res = Value::make(- n.getInt());
     else
-      res = NUMBER_VAL(- n->getFloat()); }
+      res = Value::make(- n.getFloat()); }
   return res;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -580,8 +679,8 @@ d::DValue Print::eval(d::IEvaluator* e){
     if(t == d::T_SEMI)
       lastSemi=true;
     else
-    if(auto res= i->eval(e); res)
-      _e->writeString(res->pr_str(0)); }
+    if(auto res= DCAST(Ast,i)->evalv(e); res)
+      _e->writeString(res.pr_str(0)); }
 
   if(k==T_PRINTLN || ! lastSemi){ _e->writeln(); }
 
@@ -599,27 +698,23 @@ d::DValue PrintSep::eval(d::IEvaluator* e){
   return NUMBER_VAL(tok()->type());
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value PrintSep::evalv(d::IEvaluator*){
+  return Value::make(tok()->type());
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Assignment::eval(d::IEvaluator* e){
+  auto _e= s__cast(Basic,e);
   auto t= DCAST(Ast,lhs)->tok()->type();
   auto _A=tok()->addr();
-  auto res= rhs->eval(e);
+  auto res= DCAST(Ast,rhs)->evalv(e);
 
   if(t == T_ARRAYINDEX){
-    auto fc = DCAST(FuncCall,lhs);
-    auto fn = fc->funcName();
-    auto& args= fc->funcArgs();
-    d::ValVec out;
-
-    for(auto& x : args)
-      s__conj(out, x->eval(e));
-
-    auto vn = PNAME(Var,fn);
-    auto vv= e->getValue(vn);
-    auto arr= vcast<BArray>(vv,_A);
-    ensure_data_type(vn,res);
-    arr->set(d::VSlice(out), res);
+    DCAST(FuncCall,lhs)->store(e, res, _A);
+  }else
+  if(typed){
+    _e->refSlot(DCAST(Var,lhs)->slot())= res;
   }else{
-    e->setValue(PNAME(Var,lhs), res); }
+    _e->setSlot(DCAST(Var,lhs)->slot(), res); }
 
   return DVAL_NIL;
 }
@@ -644,28 +739,36 @@ void Assignment::visit(d::IAnalyzer* a){
   lhs->visit(a);
   rhs->visit(a);
 
-  if(t != T_ARRAYINDEX)
-    a->define(d::Symbol::make(vn));
+  if(t != T_ARRAYINDEX){
+    typed= DCAST(Ast,rhs)->vtype() == sigil_type(vn);
+    a->define(d::Symbol::make(vn)); }
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-ArrayDecl::ArrayDecl(d::DToken t, d::DAst v, const IntVec& sizes) : Ast(t){
+ArrayDecl::ArrayDecl(d::DToken t, d::DAst v, const d::AstVec& szs, bool s) : Ast(t){
   auto n= PNAME(Var,v);
   stringType =(n[n.length()-1] == '$');
+  sparse=s;
   var=v;
-  s__ccat(ranges,sizes);
+  s__ccat(sizes,szs);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr ArrayDecl::pr_str() const{
   stdstr b, buf;
-  buf = PRN(var) + stdstr("(");
-  for(auto& x : ranges)
-    b += stdstr(b.empty()?"":",") + N_STR(x);
+  buf = stdstr(sparse ? "SPARSE " : "") + PRN(var) + stdstr("(");
+  for(auto& x : sizes)
+    b += stdstr(b.empty()?"":",") + PRN(x);
   return buf + b + ")";
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue ArrayDecl::eval(d::IEvaluator* e){
-  auto n= PNAME(Var,var);
-  return e->setValue(n, BArray::make(ranges));
+  auto v= DCAST(Var,var);
+  auto _A= tok()->addr();
+  IntVec dims;
+  for(auto& x : sizes)
+    s__conj(dims, BArray::dim(DCAST(Ast,x)->evalv(e), _A));
+  // the array itself is not checked against the sigil.
+  return (s__cast(Basic,e)->refSlot(v->slot())=
+          Value::make(BArray::make(dims, array_type(v->name()), sparse))).obj();
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 void ArrayDecl::visit(d::IAnalyzer* a){
@@ -674,9 +777,38 @@ void ArrayDecl::visit(d::IAnalyzer* a){
   if(auto c= a->find(n); c)
     E_SEMANTIC("Duplicate array var %s near %s.",
                  n.c_str(), d::pr_addr(_A).c_str());
+  for(auto& x : sizes)
+    x->visit(a);
+  var->visit(a);
   a->define(d::Symbol::make(n, d::Symbol::make("ARRAY")));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr MatStmt::pr_str() const{
+  static const char* ops[]= {"", " + ", " - ", " * ", "", "TRN", "ZER", "CON", "IDN"};
+  auto buf= stdstr("MAT ") + PRN(var) + " = ";
+  switch(op){
+    case MAT_ZER: case MAT_CON: case MAT_IDN: return buf + ops[op];
+    case MAT_TRN: return buf + "TRN(" + PRN(lhs) + ")";
+    case MAT_SCALE: return buf + "(" + PRN(lhs) + ") * " + PRN(rhs);
+    case MAT_COPY: return buf + PRN(lhs);
+  }
+  return buf + PRN(lhs) + ops[op] + PRN(rhs);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue MatStmt::eval(d::IEvaluator* e){
+  Value x, y;
+  if(lhs) x= DCAST(Ast,lhs)->evalv(e);
+  if(rhs) y= DCAST(Ast,rhs)->evalv(e);
+  mat_run(op, DCAST(Ast,var)->evalv(e), x, y, tok()->addr());
+  return P_NIL;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void MatStmt::visit(d::IAnalyzer* a){
+  var->visit(a);
+  if(lhs) lhs->visit(a);
+  if(rhs) rhs->visit(a);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue Comment::eval(d::IEvaluator*){ return P_NIL; }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Comment::pr_str() const{
@@ -690,17 +822,17 @@ d::DValue Input::eval(d::IEvaluator* e){
   auto _e= s__cast(Basic,e);
   auto res= _e->readString();
   auto cs= res.c_str();
-  auto v= DVAL_NIL;
+  Value v;
 
   if(vn[vn.size()-1]=='$')
-    v= STRING_VAL(res);
+    v= Value::make(res);
   else
   if(::strchr(cs, '.'))
-    v= NUMBER_VAL(::atof(cs));
+    v= Value::make(::atof(cs));
   else
-    v= NUMBER_VAL(::atoi(cs));
+    v= Value::make(::atoi(cs));
 
-  return e->setValue(vn,v), DVAL_NIL;
+  return _e->setSlot(DCAST(Var,var)->slot(),v), DVAL_NIL;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 stdstr Input::pr_str() const{
@@ -710,29 +842,42 @@ stdstr Input::pr_str() const{
   return buf + " " + PRN(var);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-BasicParser::BasicParser(const Tchar* src){
-  lex=new Lexer(src);
+BasicParser::BasicParser(const Tchar* src, int len, bool par) : par(par){
+  lex=new Lexer(src, len, buf);
+  toks=buf.data();
+  ntoks=buf.size();
+  stop=ntoks-1;
   curLine=1;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-BasicParser::~BasicParser(){ DEL_PTR(lex); }
+BasicParser::BasicParser(const BasicParser* whole,
+                         int from, int to, const std::map<stdstr,int>& dims)
+  : dims(dims), lex(whole->lex), owner(false),
+    toks(whole->toks), ntoks(whole->ntoks), stop(to), pos(from){
+  curLine=1;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+BasicParser::~BasicParser(){ if(owner) DEL_PTR(lex); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken BasicParser::eat(int wanted){
-  auto t= lex->ctx().cur;
-  if(t->type() != wanted){
+  if(toks[pos].type != wanted){
+    auto t= tok();
     auto _A=t->addr();
     E_SYNTAX("Wanted token %s, got %s near %s",
               typeToString(wanted).c_str(), PSTR(t), d::pr_addr(_A).c_str()); }
-  return (lex->ctx().cur=lex->getNextToken(), t);
+  return eat();
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken BasicParser::eat(){
-  auto t= lex->ctx().cur;
-  return (lex->ctx().cur=lex->getNextToken(), t);
+  auto t= tok();
+  // stays on the eof.
+  if(pos+1 < ntoks) ++pos;
+  curTok=nullptr;
+  return t;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool BasicParser::isEof() const{
-  return lex->ctx().cur->type() == d::T_EOF;
+  return toks[pos].type == d::T_EOF;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst assignment(BasicParser* bp, d::DAst lhs){
@@ -760,6 +905,21 @@ d::DAst funcall(BasicParser* bp, d::DAst name){
   bp->eat(d::T_RPAREN);
   return FuncCall::make( d::Token::make(T_FUNCALL,"()",t->addr()),name, pms); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst arrayRef(BasicParser* bp, d::DAst fc){
+  // only arrays DIMed earlier in the source, with the same rank.
+  auto c= DCAST(FuncCall,fc);
+  auto& pms= c->funcArgs();
+  auto n= (int) pms.size();
+  if(bp->rank(PNAME(Var,c->funcName())) != n)
+    return fc;
+  switch(n){
+    case 1: return ArrayRef<1>::make(c->tok(), c->funcName(), pms);
+    case 2: return ArrayRef<2>::make(c->tok(), c->funcName(), pms);
+    case 3: return ArrayRef<3>::make(c->tok(), c->funcName(), pms);
+  }
+  return fc;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst skipComment(BasicParser* bp){
   auto k= bp->eat();
   d::TokenVec tkns;
@@ -937,14 +1097,34 @@ d::DAst endProg(BasicParser* bp){
   return End::make( bp->eat(T_END));
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// binding power of the binary operators, 0 if not one.
+enum{ P_NONE=0, P_REL, P_ADD, P_MUL, P_POW };
+struct OpInfo{ int type; int prec; };
+constexpr OpInfo BINOPS[]= {
+  {d::T_GT, P_REL}, {d::T_LT, P_REL}, {T_GTEQ, P_REL},
+  {T_LTEQ, P_REL}, {d::T_EQ, P_REL}, {T_NOTEQ, P_REL},
+  {d::T_PLUS, P_ADD}, {d::T_MINUS, P_ADD},
+  {d::T_MULT, P_MUL}, {d::T_DIV, P_MUL}, {T_INT_DIV, P_MUL}, {T_MOD, P_MUL},
+  {T_POWER, P_POW}
+};
+static_assert([]{
+  for(auto& x : BINOPS) if(x.type < 0 || x.type > T_EOL) return false;
+  return true; }(), "operator types must index the table");
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// indexed by token type, all of which are below T_EOL.
+const auto PRECS= []{
+  std::array<char, T_EOL+1> m{};
+  for(auto& x : BINOPS) m[x.type]= x.prec;
+  return m; }();
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int binding(int type){
+  return type >= 0 && type < (int) PRECS.size() ? PRECS[type] : P_NONE;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst binary(BasicParser*, int);
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst relation(BasicParser* bp){
-  static std::set<int> ops1 { d::T_GT, d::T_LT, T_GTEQ };
-  static std::set<int> ops2 { T_LTEQ, d::T_EQ, T_NOTEQ };
-  auto res = expr(bp);
-  while(s__contains(ops1, bp->cur()) ||
-        s__contains(ops2, bp->cur()) )
-    res= RelationOp::make(res, bp->eat(), expr(bp));
-  return res;
+  return binary(bp, P_REL);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst b_factor(BasicParser* bp){ return relation(bp); }
@@ -967,11 +1147,10 @@ d::DAst b_term(BasicParser* bp){
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst b_expr(BasicParser* bp){
-  static std::set<int> ops {T_OR, T_XOR};
   d::AstVec res { b_term(bp) };
   d::TokenVec ts;
   auto k= DCAST(Ast,res[0])->tok();
-  while(s__contains(ops, bp->cur())){
+  while(bp->isCur(T_OR) || bp->isCur(T_XOR)){
     s__conj(ts, bp->tok());
     bp->eat();
     s__conj(res, b_term(bp));
@@ -986,7 +1165,7 @@ d::DAst variable(BasicParser* bp){
     return t;
   }else{
     auto m=DCAST(Ast,t)->tok()->addr();
-    auto fc= funcall(bp,t);
+    auto fc= arrayRef(bp, funcall(bp,t));
     DCAST(FuncCall,fc)->setArray(m);
     return fc;
   }
@@ -1022,47 +1201,77 @@ d::DAst factor(BasicParser* bp){
   return res;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DAst term2(BasicParser* bp){
-  static std::set<int> ops { T_POWER };
+// precedence climbing, lo is the weakest operator we may take.
+d::DAst binary(BasicParser* bp, int lo){
   auto res= factor(bp);
-
-  //res = d::DAst(new BinOp(res, bp->eat(), factor(bp)));
-  //handles right associativity
-  while(s__contains(ops,bp->cur()))
-    res = BinOp::make(res, bp->eat(), term2(bp));
-
-  return res;
-}
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DAst term(BasicParser* bp){
-  static std::set<int> ops {d::T_MULT,d::T_DIV, T_INT_DIV, T_MOD};
-  auto res= term2(bp);
-  while(s__contains(ops,bp->cur()))
-    res = BinOp::make(res, bp->eat(), term2(bp));
+  for(auto p= binding(bp->cur()); p >= lo; p= binding(bp->cur())){
+    auto t= bp->eat();
+    // ^ is right associative.
+    auto rhs= binary(bp, p == P_POW ? p : p+1);
+    res= p == P_REL ? RelationOp::make(res, t, rhs)
+                    : BinOp::make(res, t, rhs);
+  }
   return res;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst expr(BasicParser* bp){
-  static std::set<int> ops {d::T_PLUS, d::T_MINUS};
-  auto res= term(bp);
-  while(s__contains(ops,bp->cur()))
-    res= BinOp::make(res, bp->eat(), term(bp));
-  return res;
+  return binary(bp, P_ADD);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst declArray(BasicParser* bp){
   auto _t = bp->eat(T_DIM);
+  // DIM SPARSE asks for pages on first write.
+  auto sparse= bp->isCur(T_SPARSE);
+  if(sparse) bp->eat();
   auto t= bp->eat(d::T_IDENT);
-  IntVec sizes;
+  d::AstVec sizes;
   bp->eat(d::T_LPAREN);
   while (! bp->isEof()){
-    s__conj(sizes, bp->eat(d::T_INT)->getInt());
+    s__conj(sizes, expr(bp));
     if(bp->isCur(d::T_RPAREN))
     break;
     bp->eat(d::T_COMMA);
   }
   bp->eat(d::T_RPAREN);
-  return ArrayDecl::make(_t, Var::make(t), sizes);
+  bp->dimmed(t->getStr(), sizes.size());
+  return ArrayDecl::make(_t, Var::make(t), sizes, sparse);
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst matStmt(BasicParser* bp){
+  auto t= bp->eat(T_MAT);
+  auto v= mkvar(bp);
+  d::DAst x, y;
+  auto op= MAT_COPY;
+  bp->eat(d::T_EQ);
+  if(bp->isCur(d::T_LPAREN)){
+    bp->eat();
+    x= expr(bp);
+    bp->eat(d::T_RPAREN);
+    bp->eat(d::T_MULT);
+    return MatStmt::make(t, MAT_SCALE, v, x, mkvar(bp));
+  }
+  auto n= bp->tok()->getStr();
+  if(n == "ZER" || n == "CON" || n == "IDN"){
+    bp->eat();
+    op= n == "ZER" ? MAT_ZER : n == "CON" ? MAT_CON : MAT_IDN;
+  }else if(n == "TRN"){
+    bp->eat();
+    bp->eat(d::T_LPAREN);
+    x= mkvar(bp);
+    bp->eat(d::T_RPAREN);
+    op= MAT_TRN;
+  }else{
+    x= mkvar(bp);
+    switch(bp->cur()){
+      case d::T_PLUS: op= MAT_ADD; break;
+      case d::T_MINUS: op= MAT_SUB; break;
+      case d::T_MULT: op= MAT_MUL; break;
+    }
+    if(op != MAT_COPY){
+      bp->eat();
+      y= mkvar(bp); }
+  }
+  return MatStmt::make(t, op, v, x, y);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst statement(BasicParser* bp){
@@ -1123,6 +1332,9 @@ d::DAst statement(BasicParser* bp){
   case T_DIM:
     res=declArray(bp);
   break;
+  case T_MAT:
+    res=matStmt(bp);
+  break;
   case T_LET: {
     auto t= bp->eat();
     auto _A=t->addr();
@@ -1139,7 +1351,7 @@ d::DAst statement(BasicParser* bp){
       res=assignment(bp, Var::make(n));
     else{
       if(bp->isCur(d::T_LPAREN)){
-        auto fc= funcall(bp, Var::make(n));
+        auto fc= arrayRef(bp, funcall(bp, Var::make(n)));
         if(!bp->isCur(d::T_EQ))
           res=fc;
         else
@@ -1202,41 +1414,133 @@ d::DAst parse_line(BasicParser* bp){
   return res;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DAst program(BasicParser* bp){
-  std::map<int,d::DAst> lines;
-  d::AstVec raws;
-  do{
+// numbered lines up to where the parser stops, later ones win.
+void lines(BasicParser* bp, std::map<int,d::DAst>& out){
+  while(!bp->done()){
     if(auto res= parse_line(bp); res){
-      auto n = bp->line();
-      if(n < 0)
-        s__conj(raws,res); else lines[n]= res; }
-  }while (!bp->isEof());
-  //std::cout << "parsed ALL lines, total count = " << lines.size() << "\n";
-  return Program::make(d::Token::make(T_PROGRAM,"<>",DMARK(1,1)), lines); }
+      if(auto n = bp->line(); n >= 0) out[n]= res; } }
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DAst program(BasicParser* bp){
+  std::map<int,d::DAst> out;
+  if(!bp->parallel(out))
+    lines(bp, out);
+  return Program::make(d::Token::make(T_PROGRAM,"<>",DMARK(1,1)), out); }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DAst BasicParser::parse(){
-  return program(this);
+  auto res= program(this);
+  // the tree has its own tokens now.
+  LexemeVec().swap(buf);
+  toks=P_NIL;
+  return res;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the ranks a sequential parse would know at each cut, the only
+// thing a line takes from the ones before it.
+std::vector<std::map<stdstr,int>>
+BasicParser::ranks(const std::vector<int>& cuts) const{
+  std::vector<std::map<stdstr,int>> out;
+  std::map<stdstr,int> dims;
+  auto k=0;
+  for(auto i=0; i < ntoks && k < (int) cuts.size(); ++i){
+    if(i == cuts[k]){ s__conj(out, dims); ++k; }
+    if(toks[i].type != T_DIM) continue;
+    auto j= i+1;
+    if(j < ntoks && toks[j].type == T_SPARSE) ++j;
+    if(j+1 >= ntoks ||
+       toks[j].type != d::T_IDENT ||
+       toks[j+1].type != d::T_LPAREN) continue;
+    // sizes are the commas at the top, plus one.
+    auto n=1, depth=1;
+    for(auto m= j+2; m < ntoks && depth > 0; ++m){
+      auto t= toks[m].type;
+      if(t == T_EOL || t == d::T_EOF) break;
+      if(t == d::T_LPAREN) ++depth;
+      else if(t == d::T_RPAREN) --depth;
+      else if(t == d::T_COMMA && depth == 1) ++n; }
+    dims[lex->name(toks[j])]= n;
+  }
+  return out;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// cut the tokens at line breaks and parse the pieces at once. Each
+// piece must end right where the next starts, with the DIMs the next
+// assumed, else we give up and parse the lot in order. An error is
+// the first piece's that has one, as in a sequential parse.
+bool BasicParser::parallel(std::map<int,d::DAst>& out){
+  static const int MIN_CHUNK= 16*1024;
+  int cores= std::thread::hardware_concurrency();
+  auto n= std::min(cores, ntoks / MIN_CHUNK);
+  if(!par || n < 2)
+    return false;
+
+  std::vector<int> cuts { pos };
+  for(auto k=1; k < n; ++k){
+    auto i= std::max((int)(k * (llong) ntoks / n), cuts.back());
+    while(i < stop && toks[i].type != T_EOL) ++i;
+    if(i+1 < stop && i+1 > cuts.back()) s__conj(cuts, i+1); }
+  s__conj(cuts, stop);
+  n= cuts.size()-1;
+  if(n < 2)
+    return false;
+
+  struct Chunk{
+    std::map<int,d::DAst> lines;
+    std::map<stdstr,int> dims;
+    std::exception_ptr err;
+    int end=0;
+  };
+  auto snaps= ranks(cuts);
+  std::vector<Chunk> chunks(n);
+  auto run= [&](int k){
+    BasicParser p(this, cuts[k], cuts[k+1], snaps[k]);
+    try{
+      lines(&p, chunks[k].lines);
+    }catch(...){
+      chunks[k].err= std::current_exception(); }
+    chunks[k].dims= p.dims;
+    chunks[k].end= p.pos;
+  };
+  std::vector<std::thread> pool;
+  for(auto k=1; k < n; ++k)
+    s__conj(pool, std::thread(run, k));
+  run(0);
+  for(auto& t : pool) t.join();
+
+  for(auto k=0; k < n; ++k){
+    auto& c= chunks[k];
+    if(c.err)
+      std::rethrow_exception(c.err);
+    if(c.end != cuts[k+1] ||
+       (k+1 < n && c.dims != snaps[k+1]))
+      return false; }
+  for(auto& c : chunks)
+    for(auto& x : c.lines) out[_1(x)]= _2(x);
+  return true;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 int BasicParser::cur(){
-  return lex->ctx().cur->type();
+  return toks[pos].type;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 Tchar BasicParser::peek(){
-  return d::peek(lex->ctx());
+  return lex->after(toks[pos]);
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool BasicParser::isCur(int type){
-  return lex->ctx().cur->type() == type;
+  return toks[pos].type == type;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DToken BasicParser::tok(){
-  return lex->ctx().cur;
+  // made only when the parser asks for it.
+  if(!curTok) curTok= lex->token(toks[pos]);
+  return curTok;
 }
 
 
 
 
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
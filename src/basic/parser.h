@@ -15,16 +15,35 @@
 
 #include "lexer.h"
 #include "types.h"
+#include "mat.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::basic{
 namespace d = czlab::dsl;
 namespace a=czlab::aeon;
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Compiler;
+struct Folder;
+struct Jit;
+struct JitCode;
+struct Emitter;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Ast : public d::Node{
 
   virtual stdstr pr_str() const{ return tok()->getStr(); }
+  // expressions override this to skip boxing.
+  virtual Value evalv(d::IEvaluator* e){ return Value::make(eval(e)); }
+  // lower this node into bytecode.
+  virtual void compile(Compiler*)=0;
+  // fold constants, returns a replacement node or nil.
+  virtual d::DAst fold(Folder*){ return P_NIL; }
+  // emit native code, false if not supported.
+  virtual bool jit(Jit*){ return false; }
+  // emit C++, returns the code for expressions.
+  virtual stdstr cpp(Emitter*)=0;
   d::DToken tok() const{ return _token; }
+  // static type, known after analysis.
+  int vtype() const{ return _vtype; }
   int line() const{ return _line; }
   int offset() const{ return _offset; }
 
@@ -37,6 +56,7 @@ struct Ast : public d::Node{
 
   Ast(d::DToken t) : _token(t){}
 
+  int _vtype=VT_ANY;
   int _offset=0;
   int _line=0;
   d::DToken _token;
@@ -45,6 +65,13 @@ struct Ast : public d::Node{
   Ast(){}
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template <typename T>
+T* acast(d::DAst a){
+  if(auto p= a.get(); p &&
+     typeid(T)==typeid(*p))
+    return s__cast(T,p); else return P_NIL;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct FuncCall : public Ast{
 
   static d::DAst make(d::DToken t, d::DAst a, const d::AstVec& v){
@@ -55,6 +82,10 @@ struct FuncCall : public Ast{
   d::DAst funcName() const{ return fn; }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer* a){
     fn->visit(a);
     for (auto& x:args) x->visit(a);
@@ -66,16 +97,40 @@ struct FuncCall : public Ast{
     _token=d::Token::make(T_ARRAYINDEX, "[]",m);
   }
 
-  private:
+  // assign to an array element.
+  virtual void store(d::IEvaluator*, const Value&, d::Addr);
+
+  protected:
 
   FuncCall(d::DToken t, d::DAst a, const d::AstVec& v) : Ast(t){
     s__ccat(args,v);
     fn=a;
   }
+  CallSite site;
   d::DAst fn;
   d::AstVec args;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// element of a DIMed array of rank N, the offset is
+// worked out from the indices without a slice.
+template<int N>
+struct ArrayRef : public FuncCall{
+
+  static d::DAst make(d::DToken t, d::DAst a, const d::AstVec& v){
+    return WRAP_AST(ArrayRef,t,a,v);
+  }
+
+  virtual Value evalv(d::IEvaluator*);
+  virtual void store(d::IEvaluator*, const Value&, d::Addr);
+  virtual ~ArrayRef(){}
+
+  private:
+
+  ArrayRef(d::DToken t, d::DAst a, const d::AstVec& v) : FuncCall(t,a,v){}
+  BArray* array(d::IEvaluator*) const;
+  int offset(d::IEvaluator*, BArray*);
+};
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct BoolTerm : public Ast{
 
   static d::DAst make(d::DToken t, const d::AstVec& v){
@@ -83,9 +138,12 @@ struct BoolTerm : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a){
-    for(auto& x:terms)x->visit(a);
-  }
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~BoolTerm(){}
 
@@ -102,9 +160,12 @@ struct BoolExpr : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a){
-    for (auto& x:terms) x->visit(a);
-  }
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~BoolExpr(){}
 
@@ -125,9 +186,12 @@ struct RelationOp : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a){
-    lhs->visit(a),rhs->visit(a);
-  }
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~RelationOp(){}
 
@@ -137,6 +201,8 @@ struct RelationOp : public Ast{
     lhs=l;
     rhs=r;
   }
+  // both sides are known numbers.
+  bool typed=0;
   d::DAst lhs;
   d::DAst rhs;
 };
@@ -148,8 +214,13 @@ struct NotFactor : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer* a){
     expr->visit(a);
+    _vtype=VT_NUM;
   }
   virtual stdstr pr_str() const;
   virtual ~NotFactor(){}
@@ -167,6 +238,10 @@ struct Assignment : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~Assignment(){}
@@ -174,6 +249,8 @@ struct Assignment : public Ast{
   private:
 
   Assignment(d::DAst l, d::DToken t, d::DAst r) : Ast(t){ lhs=l; rhs=r; }
+  // rhs type matches the var, no check needed.
+  bool typed=0;
   d::DAst lhs;
   d::DAst rhs;
 };
@@ -185,15 +262,20 @@ struct BinOp : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a){
-    lhs->visit(a),rhs->visit(a);
-  }
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~BinOp(){}
 
   protected:
 
   BinOp(d::DAst l, d::DToken t, d::DAst r) : Ast(t){ lhs=l; rhs=r; }
+  // both sides are known numbers.
+  bool typed=0;
   d::DAst lhs;
   d::DAst rhs;
 };
@@ -201,6 +283,10 @@ struct BinOp : public Ast{
 struct Num : public Ast{
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual bool jit(Jit*);
   virtual void visit(d::IAnalyzer*){}
   static d::DAst make(d::DToken t){
     return WRAP_AST(Num,t);
@@ -210,12 +296,19 @@ struct Num : public Ast{
 
   protected:
 
-  Num(d::DToken t) : Ast(t){}
+  Num(d::DToken t) : Ast(t){
+    num= t->type() == d::T_INT
+         ? Value::make(t->getInt()) : Value::make(t->getFloat());
+    _vtype=VT_NUM; }
+  Value num;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct String : public Ast{
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
   virtual void visit(d::IAnalyzer*){}
 
   static d::DAst make(d::DToken t){
@@ -227,14 +320,23 @@ struct String : public Ast{
 
   protected:
 
-  String(d::DToken t) : Ast(t){}
+  String(d::DToken t) : Ast(t){
+    str= Value::make(t->getStr());
+    _vtype=VT_STR; }
+  Value str;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Var : public Ast{
 
   stdstr name() const{ return tok()->getStr(); }
+  int slot() const{ return _slot; }
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer*){}
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual bool jit(Jit*);
+  virtual d::DAst fold(Folder*);
+  virtual void visit(d::IAnalyzer*);
 
   static d::DAst make(d::DToken t){
     return WRAP_AST(Var,t);
@@ -245,6 +347,7 @@ struct Var : public Ast{
   protected:
 
   Var(d::DToken t) : Ast(t){}
+  int _slot= -1;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct UnaryOp : public Ast{
@@ -254,8 +357,14 @@ struct UnaryOp : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
   virtual void visit(d::IAnalyzer* a){
     expr->visit(a);
+    _vtype=VT_NUM;
   }
   virtual stdstr pr_str() const;
   virtual ~UnaryOp(){}
@@ -269,6 +378,8 @@ struct UnaryOp : public Ast{
 struct Run : public Ast{
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
   virtual void visit(d::IAnalyzer*){}
 
   static d::DAst make(d::DToken t){
@@ -284,6 +395,8 @@ struct Run : public Ast{
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Restore : public Ast{
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
   virtual void visit(d::IAnalyzer*){}
   static d::DAst make(d::DToken t){
     return WRAP_AST(Restore,t);
@@ -298,6 +411,9 @@ struct Restore : public Ast{
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct End : public Ast{
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*){}
   static d::DAst make(d::DToken t){
     return WRAP_AST(End,t);
@@ -318,6 +434,9 @@ struct Read : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual stdstr pr_str() const;
   virtual void visit(d::IAnalyzer* a){
     for (auto& x:vars) x->visit(a);
@@ -336,6 +455,9 @@ struct Read : public Ast{
 struct GoSubReturn : public Ast{
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*){}
   static d::DAst make(d::DToken t){
     return WRAP_AST(GoSubReturn,t);
@@ -355,9 +477,10 @@ struct GoSub : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a){
-    expr->visit(a);
-  }
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~GoSub(){}
 
@@ -366,6 +489,8 @@ struct GoSub : public Ast{
   GoSub(d::DToken t, d::DAst a) : Ast(t){
     expr=a;
   }
+  // program position, if the target is constant.
+  int target=-1;
   d::DAst expr;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -376,9 +501,11 @@ struct Goto : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a){
-    expr->visit(a);
-  }
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
+  virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~Goto(){}
 
@@ -387,6 +514,8 @@ struct Goto : public Ast{
   Goto(d::DToken t, d::DAst a) : Ast(t){
     expr=a;
   }
+  // program position, if the target is constant.
+  int target=-1;
   d::DAst expr;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -397,9 +526,10 @@ struct OnXXX : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
-  virtual void visit(d::IAnalyzer* a){
-    var->visit(a);
-  }
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual void visit(d::IAnalyzer*);
   virtual ~OnXXX(){}
 
   private:
@@ -407,6 +537,7 @@ struct OnXXX : public Ast{
   OnXXX(d::DToken, d::DAst, d::TokenVec&);
   d::DAst var;
   IntVec targets;
+  IntVec posns;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Defun : public Ast{
@@ -416,6 +547,9 @@ struct Defun : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual ~Defun(){}
 
@@ -439,6 +573,9 @@ struct ForNext : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~ForNext(){}
@@ -447,6 +584,7 @@ struct ForNext : public Ast{
 
   ForNext(d::DToken t, d::DAst v) : Ast(t){ var=v; }
   ForNext(d::DToken t) : Ast(t){}
+  DslFLInfo info;
   d::DAst var;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -457,6 +595,9 @@ struct ForLoop : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~ForLoop(){}
@@ -466,12 +607,16 @@ struct ForLoop : public Ast{
   ForLoop(d::DToken k, d::DAst v, d::DAst i, d::DAst t, d::DAst s) : Ast(k){
     var = v; init = i; term = t; step = s;
   }
+  DslFLInfo info;
   d::DAst var,init,term,step;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct PrintSep : public Ast{
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual Value evalv(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
   virtual void visit(d::IAnalyzer*){}
   static d::DAst make(d::DToken t){
     return WRAP_AST(PrintSep,t);
@@ -491,6 +636,9 @@ struct Print : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer* a){
     for (auto& x:exprs) x->visit(a);
   }
@@ -516,6 +664,10 @@ struct IfThen : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
   virtual void visit(d::IAnalyzer* a){
     cond->visit(a);
     then->visit(a);
@@ -538,6 +690,9 @@ struct Program : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~Program(){}
@@ -556,16 +711,24 @@ struct Compound : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual bool jit(Jit*);
   virtual void visit(d::IAnalyzer* a){
     for (auto& x:stmts) x->visit(a);
   }
   virtual stdstr pr_str() const;
+  int count() const{ return (int) stmts.size(); }
   virtual ~Compound(){}
 
   private:
 
   Compound(d::DToken,int line, const d::AstVec&);
   d::AstVec stmts;
+  // native code, once the line gets hot.
+  std::shared_ptr<JitCode> native;
+  int hits=0;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Data : public Ast{
@@ -575,6 +738,9 @@ struct Data : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~Data(){}
@@ -594,6 +760,9 @@ struct Input : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer* a){
     var->visit(a);
     if (prompt) prompt->visit(a);
@@ -618,6 +787,8 @@ struct Comment : public Ast{
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
   virtual void visit(d::IAnalyzer*){}
   virtual stdstr pr_str() const;
   virtual ~Comment(){}
@@ -632,21 +803,50 @@ struct Comment : public Ast{
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct ArrayDecl : public Ast{
 
-  static d::DAst make(d::DToken n, d::DAst t, const IntVec& v){
-    return WRAP_AST(ArrayDecl,n,t,v);
+  static d::DAst make(d::DToken n, d::DAst t, const d::AstVec& v, bool sparse){
+    return WRAP_AST(ArrayDecl,n,t,v,sparse);
   }
 
   virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
   virtual void visit(d::IAnalyzer*);
   virtual stdstr pr_str() const;
   virtual ~ArrayDecl(){}
 
   private:
 
-  ArrayDecl(d::DToken, d::DAst, const IntVec&);
+  ArrayDecl(d::DToken, d::DAst, const d::AstVec&, bool);
   bool stringType;
+  bool sparse;
+  d::DAst var;
+  d::AstVec sizes;
+};
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct MatStmt : public Ast{
+
+  // x and y as taken by mat_run, x is the scalar for MAT_SCALE.
+  static d::DAst make(d::DToken t, int op, d::DAst v, d::DAst x, d::DAst y){
+    return WRAP_AST(MatStmt,t,op,v,x,y);
+  }
+
+  virtual d::DValue eval(d::IEvaluator*);
+  virtual void compile(Compiler*);
+  virtual stdstr cpp(Emitter*);
+  virtual d::DAst fold(Folder*);
+  virtual void visit(d::IAnalyzer*);
+  virtual stdstr pr_str() const;
+  virtual ~MatStmt(){}
+
+  private:
+
+  MatStmt(d::DToken t, int o, d::DAst v, d::DAst x, d::DAst y)
+    : Ast(t), op(o), var(v), lhs(x), rhs(y){}
+  int op;
   d::DAst var;
-  IntVec ranges;
+  d::DAst lhs;
+  d::DAst rhs;
 };
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct BasicParser : public d::IParser{
@@ -658,10 +858,19 @@ struct BasicParser : public d::IParser{
   int line() const{ return curLine; }
   void setLine(int n){ curLine=n;}
 
-  BasicParser(const Tchar* src);
+  // par: big sources are cut at line breaks and parsed on all cores.
+  BasicParser(const Tchar* src, int len, bool par=false);
   virtual ~BasicParser();
 
   d::DAst parse();
+  // rank of a DIMed array, 0 if not seen yet.
+  int rank(cstdstr& n) const{
+    auto i= dims.find(n); return i != dims.end() ? _2_(i) : 0; }
+  void dimmed(cstdstr& n, int r){ dims[n]=r; }
+  // no more lines for this parser.
+  bool done() const{ return isEof() || pos >= stop; }
+  // all the lines on all cores, false if it didn't.
+  bool parallel(std::map<int,d::DAst>&);
   int cur();
   char peek();
   bool isCur(int);
@@ -669,7 +878,21 @@ struct BasicParser : public d::IParser{
 
   private:
 
+  // parses [from, to) of another's tokens, dims as they were at from.
+  BasicParser(const BasicParser*, int from, int to, const std::map<stdstr,int>& dims);
+  std::vector<std::map<stdstr,int>> ranks(const std::vector<int>&) const;
+
+  std::map<stdstr,int> dims;
   Lexer* lex;
+  bool owner=true;
+  bool par=false;
+  // the lexed source, walked by index.
+  LexemeVec buf;
+  const Lexeme* toks;
+  int ntoks=0;
+  int stop=0;
+  d::DToken curTok;
+  int pos=0;
   int curLine;
 };
 
@@ -0,0 +1,124 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include <cstring>
+
+#if defined(__GNUC__)
+#define UBASIC_SIMD 1
+#else
+#define UBASIC_SIMD 0
+#endif
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic::simd{
+
+#if UBASIC_SIMD
+// four lanes, split or fused to fit the target's registers.
+typedef double V4 __attribute__((vector_size(32)));
+
+inline void load(V4& v, const double* p){ std::memcpy(&v, p, sizeof(V4)); }
+inline void save(double* p, const V4& v){ std::memcpy(p, &v, sizeof(V4)); }
+inline double total(const V4& v){ return (v[0] + v[1]) + (v[2] + v[3]); }
+#endif
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// y += a * x
+inline void axpy(double* __restrict y,
+                 const double* __restrict x, double a, int n){
+  int i=0;
+#if UBASIC_SIMD
+  V4 k= {a,a,a,a};
+  for(V4 u,v; i+4 <= n; i += 4){
+    load(u, x+i);
+    load(v, y+i);
+    v += k * u;
+    save(y+i, v); }
+#endif
+  for(; i < n; ++i) y[i] += a * x[i];
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// z = x + s * y
+inline void axpby(double* __restrict z, const double* __restrict x,
+                  const double* __restrict y, double s, int n){
+  int i=0;
+#if UBASIC_SIMD
+  V4 k= {s,s,s,s};
+  for(V4 u,v; i+4 <= n; i += 4){
+    load(u, x+i);
+    load(v, y+i);
+    u += k * v;
+    save(z+i, u); }
+#endif
+  for(; i < n; ++i) z[i] = x[i] + s * y[i];
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+inline double sum(const double* x, int n){
+  double res=0;
+  int i=0;
+#if UBASIC_SIMD
+  V4 a= {0,0,0,0};
+  for(V4 u; i+4 <= n; i += 4){
+    load(u, x+i);
+    a += u; }
+  res= total(a);
+#endif
+  for(; i < n; ++i) res += x[i];
+  return res;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+inline double dot(const double* x, const double* y, int n){
+  double res=0;
+  int i=0;
+#if UBASIC_SIMD
+  V4 a= {0,0,0,0};
+  for(V4 u,v; i+4 <= n; i += 4){
+    load(u, x+i);
+    load(v, y+i);
+    a += u * v; }
+  res= total(a);
+#endif
+  for(; i < n; ++i) res += x[i] * y[i];
+  return res;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// smallest, or largest if hi, n > 0.
+inline double extreme(const double* x, int n, bool hi){
+  double res= x[0];
+  int i=0;
+#if UBASIC_SIMD
+  if(n >= 4){
+    V4 a, v;
+    load(a, x);
+    for(i=4; i+4 <= n; i += 4){
+      load(v, x+i);
+      a= hi ? (v > a ? v : a) : (v < a ? v : a); }
+    for(int j=0; j < 4; ++j)
+      if(hi ? a[j] > res : a[j] < res) res= a[j]; }
+#endif
+  for(; i < n; ++i)
+    if(hi ? x[i] > res : x[i] < res) res= x[i];
+  return res;
+}
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
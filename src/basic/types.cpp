@@ -12,8 +12,10 @@
  *
  * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
 
+#include <climits>
 #include "lexer.h"
-#include "types.h"
+#include "parser.h"
+#include "simd.h"
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 namespace czlab::basic{
@@ -34,67 +36,406 @@ d::DValue expected(cstdstr& m, d::DValue v){
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-BArray::~BArray(){ DEL_PTR(value); }
+const Value& expected_num(const Value& v, d::Addr k){
+  d::Number n;
+  if(_1(k) == 0 &&
+     _2(k) == 0)
+    expected(n.rtti(), v.box());
+  else
+    expected(n.rtti(), v.box(), k);
+  return v;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value Value::make(d::DValue v){
+  Value r;
+  if(auto n= vcast<d::Number>(v); n){
+    r= n->isInt() ? make(n->getInt()) : make(n->getFloat());
+  }else if(v){
+    r.tag=V_OBJ;
+    r.kind=kind_of(v.get());
+    r._obj=v; }
+  return r;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int kind_of(const d::Data* p){
+  if(!p)
+    return K_NONE;
+  auto& t= typeid(*p);
+  if(t == typeid(d::Number)) return K_NUMBER;
+  if(t == typeid(d::String)) return K_STRING;
+  return s__cast(const Object,p)->kind();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue Value::box() const{
+  switch(tag){
+  case V_INT: return NUMBER_VAL(u.n);
+  case V_REAL: return NUMBER_VAL(u.r);
+  }
+  return _obj;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool Value::equals(const Value& rhs) const{
+  if(isNum() && rhs.isNum())
+    return (isInt() && rhs.isInt())
+           ? u.n == rhs.u.n : getFloat() == rhs.getFloat();
+  if(tag == V_OBJ && rhs.tag == V_OBJ)
+    return _obj->equals(rhs._obj);
+  return tag == rhs.tag;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Value::pr_str(bool p) const{
+  // let the boxed type decide how numbers print.
+  auto v= box();
+  return v ? v->pr_str(p) : "";
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-BArray::BArray(const IntVec& szs){
+BArray::BArray(const IntVec& szs, int t, bool lazy) : Object(K_ARRAY){
   //DIM(2,2,2) => 3 x 3 x 3 = 27
-  int len = 1;
-  for(auto& n : szs){
-    auto actual = n+1;
-    len = len * actual;
-    s__conj(ranges,actual); }
+  llong n = 1;
+  for(auto& z : szs){
+    auto actual = z+1;
+    s__conj(strides,(int) n);
+    n = n * actual;
+    s__conj(ranges,actual);
+    if(n > INT_MAX){
+      // the sizes asked for, ranges is only half built.
+      stdstr buf;
+      for(auto& x : szs)
+        buf += (buf.empty()?"":",") + N_STR(x);
+      E_SEMANTIC("Array too large, got DIM(%s)", C_STR(buf)); } }
+
+  ASSERT(n >= 0,
+         "Array size >= 0, got %d", (int) n);
+
+  len= (int) n;
+  type=t;
+  sparse= lazy || len >= SPARSE_MIN;
+  switch(type){
+    case AT_STR:
+      strs.init(len, sparse, Value::make(stdstr()));
+    break;
+    case AT_FLOAT:
+      floats.init(len, sparse, 0.0f);
+    break;
+    case AT_NUM:
+      reals.init((len+63)/64, sparse, 0);
+      // numbers keep their cells too.
+      [[fallthrough]];
+    default:
+      cells.init(len, sparse, Cell{0});
+    break;
+  }
+}
 
-  ASSERT(len >= 0,
-         "Array size >= 0, got %d", len);
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BArray::set(ValSlice pms, const Value& v){
+  return set(index(pms), v);
+}
 
-  value=new d::ValVec(len);
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BArray::get(ValSlice pms){
+  return get(index(pms));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue BArray::set(d::VSlice pms, d::DValue v){
-  int pos = index(pms);
-  if(pos < 0 || pos >= value->size())
+void BArray::bounds(int pos, const char* op) const{
+  if(pos < 0 || pos >= len)
     RAISE(d::IndexOOB,
-          "Array::set, index out of bound, got %d", pos);
-  value->operator[](pos)= v;
-  return v;
+          "Array::%s, index out of bound, got %d", op, pos);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue BArray::get(d::VSlice pms){
-  int pos= index(pms);
-  if(pos < 0 || pos >= value->size())
-    RAISE(d::IndexOOB,
-          "Array::get, index out of bound, got %d", pos);
-  return value->operator[](pos);
-}
-
-//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-int BArray::index(d::VSlice pms){
-  if(ranges.size() != pms.size())
-    E_SEMANTIC("Mismatch DIMs, wanted %d, got %d",
-               (int) ranges.size(), (int) pms.size());
-  //algo= z * (XY) + yX + x
-  //DIM(3,3,3) A(2,2,2)
-  auto X=0,Y=0,Z=0;
-  auto x=0,y=0,z=0;
-  for(int i=0,e=pms.size();i<e;++i){
-    auto v= *(pms.begin+i);
-    auto num= vcast<d::Number>(v);
-    if(!(num && num->isInt()))
-      E_SEMANTIC("Array index expected Int, got %s", PRV(v,1));
-    switch(i){
-    case 0:
-      X=ranges[i]; x= num->getInt(); break;
-    case 1:
-      Y=ranges[i]; y= num->getInt(); break;
-    case 2:
-      Z=ranges[i]; z= num->getInt(); break;
+// a real going into a % array keeps its whole part, rounded toward zero.
+static llong whole(double f){
+  if(!(f >= -0x1p63 && f < 0x1p63))
+    E_SEMANTIC("Int array can't hold %g", f);
+  return (llong) f;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BArray::set(int pos, const Value& v){
+  bounds(pos, "set");
+  if(type == AT_STR){
+    if(E_NIL(vcast<d::String>(v)))
+      E_SYNTAX("Wanted string, got %s", C_STR(v.pr_str(1)));
+    strs.put(pos)= v;
+  }else{
+    if(!v.isNum())
+      E_SYNTAX("Wanted number, got %s", C_STR(v.pr_str(1)));
+    switch(type){
+      case AT_INT: cells.put(pos).n= v.isInt() ? v.u.n : whole(v.u.r); break;
+      case AT_REAL: cells.put(pos).r= v.getFloat(); break;
+      case AT_FLOAT: floats.put(pos)= (float) v.getFloat(); break;
+      default: {
+        // plain numbers keep whatever they were given.
+        auto bit= 1LL << (pos & 63);
+        if(v.isInt()){
+          cells.put(pos).n= v.u.n;
+          if(reals.get(pos >> 6) & bit)
+            reals.put(pos >> 6) &= ~bit;
+        }else{
+          cells.put(pos).r= v.u.r;
+          reals.put(pos >> 6) |= bit; } }
+      break;
     }
   }
-  Z= z * (X * Y) + y * X + x;
-  return Z;
+  return get(pos);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BArray::get(int pos) const{
+  bounds(pos, "get");
+  switch(type){
+    case AT_STR: return strs.get(pos);
+    case AT_INT: return Value::make(cells.get(pos).n);
+    case AT_REAL: return Value::make(cells.get(pos).r);
+    case AT_FLOAT: return Value::make((double) floats.get(pos));
+  }
+  return (reals.get(pos >> 6) >> (pos & 63)) & 1
+         ? Value::make(cells.get(pos).r) : Value::make(cells.get(pos).n);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// kernels walk the array a page at a time, so a run never spans pages.
+const int BLOCK= Cells<float>::PAGE;
+static int run(int pos, int len){ return len-pos < BLOCK ? len-pos : BLOCK; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+const double* BArray::doubles(int pos, int n, double* tmp) const{
+  auto p= cells.block(pos);
+  switch(type){
+    case AT_REAL:
+      if(p) return &p->r;
+    break;
+    case AT_INT:
+      if(p){
+        for(int i=0; i < n; ++i) tmp[i]= (double) p[i].n;
+        return tmp; }
+    break;
+    case AT_FLOAT:
+      if(auto f= floats.block(pos); f){
+        for(int i=0; i < n; ++i) tmp[i]= f[i];
+        return tmp; }
+    break;
+    default:
+      if(p){
+        for(int i=0; i < n; i += 64){
+          auto w= reals.get((pos+i) >> 6);
+          for(int j=i, e= (n-i < 64 ? n : i+64); j < e; ++j)
+            tmp[j]= (w >> (j-i)) & 1 ? p[j].r : (double) p[j].n; }
+        return tmp; }
+    break;
+  }
+  for(int i=0; i < n; ++i) tmp[i]=0;
+  return tmp;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+const llong* BArray::ints(int pos, int n, llong* tmp) const{
+  if(auto p= cells.block(pos); p) return &p->n;
+  for(int i=0; i < n; ++i) tmp[i]=0;
+  return tmp;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BArray::store(int pos, int n, const double* x){
+  if(type == AT_FLOAT){
+    auto f= floats.block(pos);
+    for(int i=0; i < n; ++i) f[i]= (float) x[i];
+    return; }
+  auto p= cells.block(pos);
+  if(type == AT_INT)
+    for(int i=0; i < n; ++i) p[i].n= whole(x[i]);
+  else
+    for(int i=0; i < n; ++i) p[i].r= x[i];
+  if(type == AT_NUM)
+    for(int i=0; i < n; i += 64) reals.put((pos+i) >> 6)= ~0LL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BArray::store(int pos, int n, const llong* x){
+  if(type == AT_FLOAT){
+    auto f= floats.block(pos);
+    for(int i=0; i < n; ++i) f[i]= (float) x[i];
+    return; }
+  auto p= cells.block(pos);
+  if(type == AT_REAL)
+    for(int i=0; i < n; ++i) p[i].r= (double) x[i];
+  else
+    for(int i=0; i < n; ++i) p[i].n= x[i];
+  if(type == AT_NUM)
+    for(int i=0; i < n; i += 64) reals.put((pos+i) >> 6)= 0;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+bool BArray::integral() const{
+  if(type == AT_INT) return true;
+  if(type != AT_NUM) return false;
+  for(int w=0, e= (len+63)/64; w < e; ++w)
+    if(reals.get(w)) return false;
+  return true;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BArray::sum() const{
+  if(integral()){
+    llong res=0;
+    std::vector<llong> tmp(BLOCK);
+    for(int pos=0; pos < len; pos += BLOCK){
+      auto n= run(pos,len);
+      auto x= ints(pos, n, tmp.data());
+      for(int i=0; i < n; ++i) res += x[i]; }
+    return Value::make(res);
+  }
+  double res=0;
+  std::vector<double> tmp(BLOCK);
+  for(int pos=0; pos < len; pos += BLOCK){
+    auto n= run(pos,len);
+    res += simd::sum(doubles(pos, n, tmp.data()), n); }
+  return Value::make(res);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BArray::extreme(bool hi) const{
+  if(integral()){
+    std::vector<llong> tmp(BLOCK);
+    auto res= ints(0, 1, tmp.data())[0];
+    for(int pos=0; pos < len; pos += BLOCK){
+      auto n= run(pos,len);
+      auto x= ints(pos, n, tmp.data());
+      for(int i=0; i < n; ++i)
+        res= hi ? (x[i] > res ? x[i] : res) : (x[i] < res ? x[i] : res); }
+    return Value::make(res);
+  }
+  std::vector<double> tmp(BLOCK);
+  auto res= doubles(0, 1, tmp.data())[0];
+  for(int pos=0; pos < len; pos += BLOCK){
+    auto n= run(pos,len);
+    auto r= simd::extreme(doubles(pos, n, tmp.data()), n, hi);
+    if(hi ? r > res : r < res) res= r; }
+  return Value::make(res);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value BArray::dot(const BArray& o) const{
+  if(integral() && o.integral()){
+    llong res=0;
+    std::vector<llong> t1(BLOCK), t2(BLOCK);
+    for(int pos=0; pos < len; pos += BLOCK){
+      auto n= run(pos,len);
+      auto x= ints(pos, n, t1.data());
+      auto y= o.ints(pos, n, t2.data());
+      for(int i=0; i < n; ++i) res += x[i] * y[i]; }
+    return Value::make(res);
+  }
+  double res=0;
+  std::vector<double> t1(BLOCK), t2(BLOCK);
+  for(int pos=0; pos < len; pos += BLOCK){
+    auto n= run(pos,len);
+    res += simd::dot(doubles(pos, n, t1.data()),
+                     o.doubles(pos, n, t2.data()), n); }
+  return Value::make(res);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BArray::fill(const Value& v){
+  // checks and converts v, then spread the first cell.
+  set(0,v);
+  switch(type){
+    case AT_STR:
+      strs.fill(len, strs.get(0), false);
+    break;
+    case AT_FLOAT: {
+      auto f= floats.get(0);
+      floats.fill(len, f, f == 0); }
+    break;
+    default: {
+      auto c= cells.get(0);
+      auto real= type == AT_NUM && (reals.get(0) & 1);
+      cells.fill(len, c, c.n == 0);
+      if(type == AT_NUM)
+        reals.fill((len+63)/64, real ? ~0LL : 0, !real); }
+    break;
+  }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BArray::copy(const BArray& src){
+  if(type == AT_STR || src.type == AT_STR){
+    for(int i=0; i < len; ++i) set(i, src.get(i));
+    return; }
+  if(type == src.type){
+    for(int pos=0; pos < len; pos += BLOCK){
+      auto n= run(pos,len);
+      if(type == AT_FLOAT){
+        auto f= src.floats.block(pos);
+        auto p= floats.block(pos);
+        for(int i=0; i < n; ++i) p[i]= f ? f[i] : 0;
+      }else{
+        auto c= src.cells.block(pos);
+        auto p= cells.block(pos);
+        for(int i=0; i < n; ++i) p[i]= c ? c[i] : Cell{0}; }
+      if(type == AT_NUM)
+        for(int i=0; i < n; i += 64)
+          reals.put((pos+i) >> 6)= src.reals.get((pos+i) >> 6); }
+    return; }
+  auto whole= src.integral();
+  std::vector<double> tmp(BLOCK);
+  std::vector<llong> t2(BLOCK);
+  for(int pos=0; pos < len; pos += BLOCK){
+    auto n= run(pos,len);
+    if(whole)
+      store(pos, n, src.ints(pos, n, t2.data()));
+    else
+      store(pos, n, src.doubles(pos, n, tmp.data())); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BArray::map(double (*fn)(double), const BArray& src){
+  std::vector<double> tmp(BLOCK), out(BLOCK);
+  for(int pos=0; pos < len; pos += BLOCK){
+    auto n= run(pos,len);
+    auto x= src.doubles(pos, n, tmp.data());
+    for(int i=0; i < n; ++i) out[i]= fn(x[i]);
+    store(pos, n, out.data()); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int BArray::index(ValSlice pms){
+  auto z= (int) ranges.size();
+  if(z != pms.size())
+    E_SEMANTIC("Mismatch DIMs, wanted %d, got %d", z, (int) pms.size());
+  auto pos=0;
+  for(int i=0; i < z; ++i){
+    auto& v= *(pms.begin+i);
+    if(!v.isInt())
+      E_SEMANTIC("Array index expected Int, got %s", C_STR(v.pr_str(1)));
+    // checked before it's narrowed.
+    check(i, v.u.n);
+    pos += (int) v.u.n * strides[i];
+  }
+  return pos;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BArray::outside(int n, llong x) const{
+  RAISE(d::IndexOOB,
+        "Array index out of bound, dim %d got %lld", n+1, x);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int BArray::dim(const Value& v, d::Addr _A){
+  auto n= vnum(v,_A).getInt();
+  if(n < 0 || n > INT_MAX-1)
+    E_SEMANTIC("Bad DIM size %s near %s",
+               C_STR(v.pr_str(1)), d::pr_addr(_A).c_str());
+  return (int) n;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -111,11 +452,9 @@ bool BArray::equals(d::DValue rhs) const{
   if(d::is_same(rhs, this)){
     auto p= DCAST(BArray, rhs);
     int i=0;
-    int len = value->size();
-    if(len == p->value->size()){
+    if(len == p->len){
       for(; i < len; ++i){
-        if(! (*value)[i]->equals(
-              p->value->operator[](i))) break; }
+        if(! get(i).equals(p->get(i))) break; }
       ok = i >= len;
     }
   }
@@ -126,11 +465,9 @@ bool BArray::equals(d::DValue rhs) const{
 int BArray::compare(d::DValue rhs) const{
   if(d::is_same(rhs, this)){
     auto p= DCAST(BArray, rhs);
-    auto len = value->size();
-    auto rz = p->value->size();
     if(equals(rhs)){ return 0; }
-    if(len > rz){ return 1; }
-    if(len < rz){ return -1; }
+    if(len > p->len){ return 1; }
+    if(len < p->len){ return -1; }
     return 0;
   }else{
     return pr_str().compare(rhs->pr_str());
@@ -138,72 +475,147 @@ int BArray::compare(d::DValue rhs) const{
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue op_math(d::DValue left, int op, d::DValue right){
-  auto rhs = vcast<d::Number>(right,DMARK_00);
-  auto lhs = vcast<d::Number>(left,DMARK_00);
-  bool ints = lhs->isInt() && rhs->isInt();
+static llong idiv(llong x, llong y){
+  // the one quotient that doesn't fit, and traps like a zero divisor.
+  if(x == LLONG_MIN && y == -1)
+    E_SEMANTIC("Int overflow, %lld / %lld", x, y);
+  return x / y;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value op_math(const Value& lhs, int op, const Value& rhs){
+  bool ints = lhs.isInt() && rhs.isInt();
   llong L;
   double R;
   switch(op){
   case T_INT_DIV:
     if(!ints)
       E_SYNTAX("Operator INT-DIV requires %d ints", 2);
-    if(rhs->isZero())
+    if(rhs.isZero())
       RAISE(d::DivByZero,
-            "Div by zero, denominator= %d", (int)rhs->getInt());
-    L = (lhs->getInt() / rhs->getInt());
+            "Div by zero, denominator= %d", (int)rhs.getInt());
+    L = idiv(lhs.getInt(), rhs.getInt());
   break;
   case d::T_PLUS:
     if(ints)
-      L = lhs->getInt() + rhs->getInt();
+      L = lhs.getInt() + rhs.getInt();
     else
-      R = lhs->getFloat() + rhs->getFloat();
+      R = lhs.getFloat() + rhs.getFloat();
   break;
   case d::T_MINUS:
     if(ints)
-      L = lhs->getInt() - rhs->getInt();
+      L = lhs.getInt() - rhs.getInt();
     else
-      R = lhs->getFloat() - rhs->getFloat();
+      R = lhs.getFloat() - rhs.getFloat();
   break;
   case d::T_MULT:
     if(ints)
-      L = lhs->getInt() * rhs->getInt();
+      L = lhs.getInt() * rhs.getInt();
     else
-      R = lhs->getFloat() * rhs->getFloat();
+      R = lhs.getFloat() * rhs.getFloat();
   break;
   case d::T_DIV:
-    if(rhs->isZero())
+    if(rhs.isZero())
       RAISE(d::DivByZero,
-            "Div by zero, denominator= %d", (int)rhs->getInt());
+            "Div by zero, denominator= %d", (int)rhs.getInt());
     if(ints)
-      L = lhs->getInt() / rhs->getInt();
+      L = idiv(lhs.getInt(), rhs.getInt());
     else
-      R = lhs->getFloat() / rhs->getFloat();
+      R = lhs.getFloat() / rhs.getFloat();
   break;
   case T_MOD:
+    if(rhs.isZero())
+      RAISE(d::DivByZero,
+            "Div by zero, denominator= %d", (int)rhs.getInt());
     if(ints)
-      L = (lhs->getInt() % rhs->getInt());
+      // x MOD -1 is 0, and LLONG_MIN % -1 traps.
+      L = rhs.getInt() == -1 ? 0 : (lhs.getInt() % rhs.getInt());
     else
-      R = ::fmod(lhs->getFloat(),rhs->getFloat());
+      R = ::fmod(lhs.getFloat(),rhs.getFloat());
   break;
   case T_POWER:
     if(ints)
-      L = ::pow(lhs->getInt(), rhs->getInt());
+      L = ::pow(lhs.getInt(), rhs.getInt());
     else
-      R = ::pow(lhs->getFloat(),rhs->getFloat());
+      R = ::pow(lhs.getFloat(),rhs.getFloat());
   break;
   }
-  return ints ? NUMBER_VAL(L) : NUMBER_VAL(R);
+  return ints ? Value::make(L) : Value::make(R);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-void ensure_data_type(cstdstr& n, d::DValue v){
+Value op_binary(const Value& lf, int t, const Value& rt, d::Addr _A){
+  if(lf.isNum() && rt.isNum())
+    return op_math(lf, t, rt);
+
+  auto s1= vcast<d::String>(lf);
+  auto s2= vcast<d::String>(rt);
+  if(s1 && s2 && t==d::T_PLUS)
+    return Value::make(s1->impl() + s2->impl());
+
+  E_SEMANTIC("Bad op `%s` near %s",
+               typeToString(t).c_str(), d::pr_addr(_A).c_str());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value op_relation(const Value& x, int k, const Value& y, d::Addr _A){
+  if(x.isNum() && y.isNum())
+    return op_relnum(x, k, y);
+  auto s1= vcast<d::String>(x);
+  auto s2= vcast<d::String>(y);
+  if(s1 && s2){
+    switch(k){
+    case d::T_EQ: return Value::make(s1->impl()==s2->impl()?1:0);
+    case T_NOTEQ: return Value::make(s1->impl()==s2->impl()?0:1);
+    }
+    E_SEMANTIC("Bad op on strings near %s", d::pr_addr(_A).c_str()); }
+  // fall through to numbers
+  return op_relnum(vnum(x,_A), k, vnum(y,_A));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Value op_relnum(const Value& xn, int k, const Value& yn){
+  auto ints = xn.isInt() && yn.isInt();
+  bool b=0;
+  switch(k){
+  case T_NOTEQ:
+    b= xn.equals(yn) ? 0 : 1;
+  break;
+  case d::T_EQ:
+    b= xn.equals(yn) ? 1 : 0;
+  break;
+  case T_GTEQ:
+    b= ints
+         ? xn.getInt() >= yn.getInt()
+         : xn.getFloat() >= yn.getFloat();
+  break;
+  case T_LTEQ:
+    b= ints
+         ? xn.getInt() <= yn.getInt()
+         : xn.getFloat() <= yn.getFloat();
+  break;
+  case d::T_GT:
+    b= ints
+         ? xn.getInt() > yn.getInt()
+         : xn.getFloat() > yn.getFloat();
+  break;
+  case d::T_LT:
+  b= ints
+       ? xn.getInt() < yn.getInt()
+       : xn.getFloat() < yn.getFloat();
+  break;
+  }
+  return Value::make(b ? 1 : 0);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void ensure_data_type(cstdstr& n, const Value& v){
   auto s= vcast<d::String>(v);
   auto cz= n[n.size()-1];
   switch(cz){
     case '$':
       if(!s)
-        E_SYNTAX("Wanted string, got %s", PRV(v,1));
+        E_SYNTAX("Wanted string, got %s", C_STR(v.pr_str(1)));
     break;
     case '!': // single
     case '#': // double
@@ -211,39 +623,43 @@ void ensure_data_type(cstdstr& n, d::DValue v){
     break;
     default:
       if(s)
-        E_SYNTAX("Wanted number, got %s", PRV(v,1));
+        E_SYNTAX("Wanted number, got %s", C_STR(v.pr_str(1)));
     break;
   }
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-Lambda::Lambda(cstdstr& name, StrVec& pms, d::DAst e) : Function(name){
+Lambda::Lambda(cstdstr& name, StrVec& pms, IntVec& ss, d::DAst e) : Function(K_LAMBDA,name){
   s__ccat(params, pms);
+  s__ccat(slots, ss);
   body=e;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue Lambda::invoke(d::IEvaluator* e, d::VSlice args){
+Value Lambda::invoke(d::IEvaluator* e, ValSlice args){
   if(args.size() != params.size())
     throw d::BadArity( (int) params.size(), (int) args.size());
 
-  // we need to create a new frame to process this defn.
-  e->pushFrame(name());
-
-  // push all args onto stack
+  // bind the args into the param slots, saving
+  // what was there so the caller sees no change.
+  auto _e= s__cast(Basic,e);
+  ValueVec saved;
   for(int i=0, z=params.size(); i < z; ++i){
-    e->setValue(params[i], *(args.begin+i));
+    auto& v= *(args.begin+i);
+    ensure_data_type(params[i], v);
+    s__conj(saved, _e->swapSlot(slots[i], v));
   }
 
-  auto res= body->eval(e);
-  e->popFrame();
+  auto res= DCAST(Ast,body)->evalv(e);
+  for(int i=0, z=params.size(); i < z; ++i)
+    _e->swapSlot(slots[i], saved[i]);
   return res;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue Lambda::invoke(d::IEvaluator* e){
-  d::ValVec vs;
-  return invoke(e, d::VSlice(vs));
+Value Lambda::invoke(d::IEvaluator* e){
+  ValueVec vs;
+  return invoke(e, ValSlice(vs));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -266,19 +682,19 @@ int Lambda::compare(d::DValue rhs) const{
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-LibFunc::LibFunc(cstdstr& name, Invoker k) : Function(name){
+LibFunc::LibFunc(cstdstr& name, Invoker k) : Function(K_LIBFUNC,name){
   fn=k;
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue LibFunc::invoke(d::IEvaluator* e, d::VSlice args){
+Value LibFunc::invoke(d::IEvaluator* e, ValSlice args){
   return fn(e, args);
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-d::DValue LibFunc::invoke(d::IEvaluator* e){
-  d::ValVec vs;
-  return invoke(e, d::VSlice(vs));
+Value LibFunc::invoke(d::IEvaluator* e){
+  ValueVec vs;
+  return invoke(e, ValSlice(vs));
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
@@ -301,6 +717,21 @@ int LibFunc::compare(d::DValue rhs) const{
            ? 0 : pr_str().compare(rhs->pr_str());
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void CallSite::resolve(const Value& f, cstdstr& name, d::Addr _A){
+  if(!f)
+    RAISE(d::NoSuchVar, "Unknown function/array: %s", name.c_str());
+  switch(f.kind){
+    case K_LIBFUNC: u.fn= vcast<LibFunc>(f)->impl(); break;
+    case K_LAMBDA: u.fd= vcast<Lambda>(f); break;
+    case K_ARRAY: u.fa= vcast<BArray>(f); break;
+    default:
+      expected("Array var or function", f.box(), _A);
+  }
+  kind= f.kind;
+  obj= f.obj();
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 bool BChar::equals(d::DValue rhs) const{
   return d::is_same(rhs, this) &&
@@ -315,6 +746,33 @@ int BChar::compare(d::DValue rhs) const{
     auto p = DCAST(BChar,rhs);
     return value==p->value ? 0 : (value > p->value ? 1 : -1); } }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LineIndex::build(const std::map<int,int>& m){
+  clear();
+  if(m.empty())
+    return;
+  auto lo= _1(*m.begin());
+  auto hi= _1(*m.rbegin());
+  // allow some holes, e.g. lines numbered by 10s.
+  if((llong) hi - lo < 16 * (llong) m.size()){
+    low=lo;
+    table.assign(hi-lo+1, -1);
+    for(auto& x : m)
+      table[_1(x)-lo] = _2(x);
+  }else{
+    for(auto& x : m){
+      s__conj(keys, _1(x));
+      s__conj(vals, _2(x)); } }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void LineIndex::clear(){
+  keys.clear();
+  vals.clear();
+  table.clear();
+  low=0;
+}
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
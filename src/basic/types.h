@@ -35,28 +35,167 @@ namespace a= czlab::aeon;
 namespace d= czlab::dsl;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-typedef d::DValue (*Invoker) (d::IEvaluator*, d::VSlice);
+enum ValueTag{
+  V_NIL,
+  V_INT,
+  V_REAL,
+  V_OBJ
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// what a boxed object is, worked out once
+// when it goes into a Value.
+enum ValueKind{
+  K_NONE,
+  K_NUMBER,
+  K_STRING,
+  K_ARRAY,
+  K_LIBFUNC,
+  K_LAMBDA,
+  K_CHAR
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// static types, inferred from literals,
+// operators and variable sigils.
+enum VType{
+  VT_ANY,
+  VT_NUM,
+  VT_STR
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+inline int sigil_type(cstdstr& n){
+  return n[n.size()-1] == '$' ? VT_STR : VT_NUM;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// element storage of an array, by name suffix.
+enum ArrayType{
+  AT_NUM,
+  AT_INT,
+  AT_REAL,
+  AT_FLOAT,
+  AT_STR
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+inline int array_type(cstdstr& n){
+  switch(n[n.size()-1]){
+    case '$': return AT_STR;
+    case '%': return AT_INT;
+    case '#': return AT_REAL;
+    case '!': return AT_FLOAT;
+  }
+  return AT_NUM;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// numbers are held inline, only strings,
+// arrays and functions get boxed.
+struct Value{
+
+  static Value make(llong n){
+    Value v; v.tag=V_INT; v.u.n=n; return v; }
+
+  static Value make(int n){ return make((llong)n); }
+
+  static Value make(double r){
+    Value v; v.tag=V_REAL; v.u.r=r; return v; }
+
+  static Value make(cstdstr& s){
+    Value v; v.tag=V_OBJ; v.kind=K_STRING; v._obj=STRING_VAL(s); return v; }
+
+  static Value make(d::DValue);
+
+  bool isNum() const{ return tag==V_INT || tag==V_REAL; }
+  bool isInt() const{ return tag==V_INT; }
+  bool isNil() const{ return tag==V_NIL; }
+
+  llong getInt() const{ return tag==V_INT ? u.n : (llong) u.r; }
+  double getFloat() const{ return tag==V_INT ? (double) u.n : u.r; }
+
+  bool isZero() const{ return tag==V_INT ? u.n==0 : u.r==0.0; }
+  bool isPos() const{ return getFloat() > 0; }
+  bool isNeg() const{ return getFloat() < 0; }
+
+  bool equals(const Value&) const;
+  stdstr pr_str(bool p=0) const;
+
+  // numbers are boxed on demand.
+  d::DValue box() const;
+  const d::DValue& obj() const{ return _obj; }
+
+  explicit operator bool() const{ return tag != V_NIL; }
+
+  Value(){ tag=V_NIL; kind=K_NONE; u.n=0; }
+
+  int tag;
+  int kind;
+  union{ llong n; double r; } u;
+  d::DValue _obj;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+typedef std::vector<Value> ValueVec;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct ValSlice{
+  ValSlice(const Value* b, const Value* e) : begin(b), end(e){}
+  ValSlice(const ValueVec& v) : begin(v.data()), end(v.data()+v.size()){}
+  int size() const{ return (int)(end-begin); }
+  const Value* begin;
+  const Value* end;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+typedef Value (*Invoker) (d::IEvaluator*, ValSlice);
 typedef std::pair<int,int> CheckPt;
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-struct Function : public d::Data{
+enum Options{
+  O_VM = 1,
+  O_FOLD = 2,
+  O_JIT = 4,
+  O_CPP = 8,
+  O_PAR = 16
+};
 
-  virtual d::DValue invoke(d::IEvaluator*, d::VSlice)=0;
-  virtual d::DValue invoke(d::IEvaluator*)=0;
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Chunk;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// the values made here, each keeps its kind so
+// only the dsl's numbers and strings need a typeid.
+struct Object : public d::Data{
+
+  int kind() const{ return _kind; }
+
+  protected:
+
+  Object(int k) : _kind(k){}
+  int _kind;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Function : public Object{
+
+  virtual Value invoke(d::IEvaluator*, ValSlice)=0;
+  virtual Value invoke(d::IEvaluator*)=0;
   stdstr name() const{ return _name; }
 
   protected:
   virtual ~Function(){}
   stdstr _name;
-  Function(){}
-  Function(cstdstr& n) : _name(n){}
+  Function(int k) : Object(k){}
+  Function(int k, cstdstr& n) : Object(k), _name(n){}
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct LibFunc : public Function{
 
-  virtual d::DValue invoke(d::IEvaluator*, d::VSlice);
-  virtual d::DValue invoke(d::IEvaluator*);
+  virtual Value invoke(d::IEvaluator*, ValSlice);
+  virtual Value invoke(d::IEvaluator*);
 
   virtual stdstr rtti() const{ return "LibFunc"; }
 
@@ -73,9 +212,11 @@ struct LibFunc : public Function{
   }
 
   //internal use only
-  LibFunc(){fn=P_NIL;}
+  LibFunc() : Function(K_LIBFUNC){fn=P_NIL;}
   virtual ~LibFunc(){}
 
+  Invoker impl() const{ return fn; }
+
   protected:
 
   LibFunc(cstdstr& name, Invoker);
@@ -85,14 +226,15 @@ struct LibFunc : public Function{
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct Lambda : public Function{
 
-  virtual d::DValue invoke(d::IEvaluator*, d::VSlice);
-  virtual d::DValue invoke(d::IEvaluator*);
+  virtual Value invoke(d::IEvaluator*, ValSlice);
+  virtual Value invoke(d::IEvaluator*);
 
   virtual stdstr rtti() const{ return "UserFunc"; }
+  int arity() const{ return (int) params.size(); }
 
   static d::DValue make(cstdstr& name,
-                        StrVec& pms, d::DAst body){
-    return WRAP_VAL(Lambda, name,pms,body);
+                        StrVec& pms, IntVec& slots, d::DAst body){
+    return WRAP_VAL(Lambda, name,pms,slots,body);
   }
 
   virtual stdstr pr_str(bool p=0) const;
@@ -101,50 +243,167 @@ struct Lambda : public Function{
 
   virtual ~Lambda(){}
   //internal use only
-  Lambda(){ }
+  Lambda() : Function(K_LAMBDA){ }
 
   protected:
 
   StrVec params;
+  IntVec slots;
   d::DAst body;
-  Lambda(cstdstr&, StrVec&, d::DAst);
+  Lambda(cstdstr&, StrVec&, IntVec&, d::DAst);
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-struct BArray : public d::Data{
+// arrays this many cells or more are always sparse.
+const int SPARSE_MIN= 1 << 20;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// array cells, either one dense block, or pages
+// that are allocated on first write.
+template<typename T>
+struct Cells{
+
+  static const int BITS= 12;
+  static const int PAGE= 1 << BITS;
+
+  void init(int n, bool paged, const T& z){
+    zero=z;
+    sparse=paged;
+    if(paged)
+      pages.resize((n + PAGE-1) >> BITS);
+    else
+      dense.assign(n, z);
+  }
+
+  const T& get(int i) const{
+    if(!sparse) return dense[i];
+    auto& p= pages[i >> BITS];
+    return p ? p[i & (PAGE-1)] : zero;
+  }
+
+  T& put(int i){
+    if(!sparse) return dense[i];
+    auto& p= pages[i >> BITS];
+    if(!p){
+      p.reset(new T[PAGE]);
+      for(auto j=0; j < PAGE; ++j) p[j]=zero; }
+    return p[i & (PAGE-1)];
+  }
+
+  // the run from i to the end of its page, nil if never written.
+  const T* block(int i) const{
+    if(!sparse) return dense.data() + i;
+    auto& p= pages[i >> BITS];
+    return p ? p.get() + (i & (PAGE-1)) : P_NIL;
+  }
+  T* block(int i){ return &put(i); }
+
+  // pages are dropped if v is the zero.
+  void fill(int n, const T& v, bool blank){
+    if(sparse && blank){
+      for(auto& p : pages) p.reset();
+      return; }
+    for(auto i=0; i < n; i += PAGE){
+      auto p= block(i);
+      for(auto j= (n-i < PAGE ? n-i : PAGE); j > 0; --j) *p++ = v; }
+  }
+
+  private:
+
+  std::vector<T> dense;
+  std::vector<std::unique_ptr<T[]>> pages;
+  T zero;
+  bool sparse=0;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct BArray : public Object{
 
   virtual stdstr rtti() const{ return "Array"; }
 
-  static d::DValue make(const IntVec& v){
-    return WRAP_VAL(BArray,v);
+  static d::DValue make(const IntVec& v, int type=AT_NUM, bool sparse=0){
+    return WRAP_VAL(BArray,v,type,sparse);
   }
 
   static d::DValue make(){
     return WRAP_VAL(BArray);
   }
 
-  d::DValue set(d::VSlice, d::DValue);
-  d::DValue get(d::VSlice);
+  Value set(ValSlice, const Value&);
+  Value get(ValSlice);
+  Value set(int pos, const Value&);
+  Value get(int pos) const;
+
+  // fixed rank paths, same layout as index().
+  int rank() const{ return (int) ranges.size(); }
+  int extent(int n) const{ return ranges[n]; }
+  // indices are checked before they're narrowed.
+  int offset(llong x) const{ return check(0,x), (int) x; }
+  int offset(llong x, llong y) const{
+    return check(0,x), check(1,y), (int) y * strides[1] + (int) x; }
+  int offset(llong x, llong y, llong z) const{
+    return check(0,x), check(1,y), check(2,z),
+           (int) z * strides[2] + (int) y * strides[1] + (int) x; }
+
+  // a DIM size, checked.
+  static int dim(const Value&, d::Addr);
+
+  int size() const{ return len; }
+  int elemType() const{ return type; }
+  bool isSparse() const{ return sparse; }
+
+  // whole array kernels, the caller checks types and sizes.
+  bool integral() const;
+  Value sum() const;
+  Value extreme(bool hi) const;
+  Value dot(const BArray&) const;
+  void fill(const Value&);
+  void copy(const BArray&);
+  void map(double (*)(double), const BArray&);
 
   virtual stdstr pr_str(bool p=0) const;
   virtual int compare(d::DValue) const;
   virtual bool equals(d::DValue) const;
 
   // internal use only
-  BArray(){ value=P_NIL;}
-  virtual ~BArray();
+  BArray() : Object(K_ARRAY){ type=AT_NUM; len=0; sparse=0; }
+  virtual ~BArray(){}
 
   protected:
 
-  BArray(const IntVec&);
-  int index(d::VSlice);
-
-  d::ValVec* value;
+  BArray(const IntVec&, int type, bool sparse);
+  int index(ValSlice);
+  void bounds(int pos, const char* op) const;
+  void check(int n, llong x) const{
+    if(x < 0 || x >= ranges[n]) outside(n,x); }
+  void outside(int n, llong x) const;
+
+  // a page of numbers from pos, in place if the store allows.
+  const double* doubles(int pos, int n, double* tmp) const;
+  const llong* ints(int pos, int n, llong* tmp) const;
+  void store(int pos, int n, const double*);
+  void store(int pos, int n, const llong*);
+
+  union Cell{ llong n; double r; };
+
+  // cells are zeroed, one store is used by type:
+  // cells for numbers, ints and reals,
+  // floats, or strs for strings.
+  Cells<Cell> cells;
+  Cells<float> floats;
+  Cells<Value> strs;
+  // AT_NUM only, a bit per cell, set if it holds a real.
+  Cells<llong> reals;
   IntVec ranges;
+  // first index varies fastest.
+  IntVec strides;
+  bool sparse;
+  int type;
+  int len;
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
-struct BChar : public d::Data{
+struct BChar : public Object{
 
   virtual stdstr rtti() const{ return "Char"; }
 
@@ -162,14 +421,77 @@ struct BChar : public d::Data{
   Tchar impl() const{ return value; }
 
   // internal use only
-  BChar(){ value=0;}
+  BChar() : Object(K_CHAR){ value=0;}
 
   protected:
 
-  BChar(const Tchar c) : value(c){}
+  BChar(const Tchar c) : Object(K_CHAR), value(c){}
   Tchar value;
 };
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// inline cache for a call site, the callee is resolved
+// once and reused until its slot holds something else.
+struct CallSite{
+
+  Value call(d::IEvaluator* e, const Value& f,
+             ValSlice args, cstdstr& name, d::Addr m){
+    if(!f.obj() || f.obj() != obj)
+      resolve(f, name, m);
+    switch(kind){
+      case K_LIBFUNC: return u.fn(e, args);
+      case K_LAMBDA: return u.fd->invoke(e, args);
+    }
+    return u.fa->get(args);
+  }
+
+  private:
+
+  void resolve(const Value&, cstdstr&, d::Addr);
+
+  // held, so the address can't be reused.
+  d::DValue obj;
+  int kind=K_NONE;
+  union{
+    Invoker fn;
+    Lambda* fd;
+    BArray* fa;
+  } u {P_NIL};
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// args up to this many are passed on the stack.
+const int ARGS_INLINE= 4;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct LineIndex{
+
+  // dense line numbers go into a direct table,
+  // sparse ones into a sorted flat array.
+  void build(const std::map<int,int>&);
+  void clear();
+
+  int find(int line) const{
+    if(!table.empty()){
+      auto i= line - low;
+      return (i >= 0 && i < (int) table.size()) ? table[i] : -1; }
+    auto n= keys.size();
+    if(n == 0) return -1;
+    auto b= keys.data();
+    while(n > 1){
+      auto h= n/2;
+      b= b[h] <= line ? b+h : b;
+      n -= h; }
+    return *b == line ? vals[b - keys.data()] : -1;
+  }
+
+  private:
+
+  IntVec keys, vals;
+  IntVec table;
+  int low=0;
+};
+
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 struct ForLoopInfo;
 typedef std::shared_ptr<ForLoopInfo> DslFLInfo;
@@ -183,15 +505,22 @@ struct ForLoopInfo{
 
   int beginOffset, endOffset;
   int begin, end;
+  // program positions of begin & end
+  int beginPos, endPos;
   stdstr var;
-  d::DValue init;
-  d::DValue step;
+  Value init;
+  Value term;
+  Value step;
+  // counter, TO and STEP are all ints
+  bool ints;
   DslFLInfo outer;
 
   private:
 
   ForLoopInfo(cstdstr& v, int n, int p){
     var=v; begin=n; end=0;
+    beginPos=endPos=0;
+    ints=0;
     beginOffset=p;
     endOffset=0;
   }
@@ -228,9 +557,25 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer{
   void uninstall();
 
   void addLambda(d::DValue);
-
-  void addData(d::DValue);
-  d::DValue readData();
+  d::DValue getLambda(cstdstr& n) const{
+    auto i= defs.find(n); return i != defs.end() ? _2_(i) : DVAL_NIL; }
+
+  // variables live in a flat store, indexed by
+  // the slot each name got during analysis.
+  int slot(cstdstr&);
+  cstdstr& slotName(int n) const{ return slotNames[n]; }
+  int slotCount() const{ return (int) slotNames.size(); }
+  const Value& getSlot(int n) const{ return slots[n]; }
+  const Value& setSlot(int, const Value&);
+  // no type check, caller knows the value fits the slot.
+  Value& refSlot(int n){ return slots[n]; }
+  // native code works on the store directly.
+  Value* slotBase(){ return slots.data(); }
+  Value swapSlot(int n, const Value& v){
+    auto o= slots[n]; slots[n]=v; return o; }
+
+  void addData(const Value&);
+  Value readData();
   void restore();
 
   void init_counters();
@@ -238,47 +583,56 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer{
 
   void halt(){ running =false; }
   bool isOn() const{ return running; }
+  bool jitOn() const{ return options & O_JIT; }
 
   int jumpSub(int target, int from, int pos);
+  int jumpSubPos(int pos, int off);
   int retSub();
   int jumpFor(DslFLInfo);
   int endFor(DslFLInfo);
   int jump(int line);
+  int jumpPos(int pos);
+  int locate(int line) const;
 
   int poffset(){ auto p= progOffset; progOffset=0; return p;}
   int pc() const{ return progCounter; };
   int incr_pc(){ return ++progCounter; }
 
   DslFLInfo getCurForLoop() const { return forLoop; }
-  DslFLInfo getForLoop(int c, int offset) const;
 
   // used during analysis
-  void xrefForNext(cstdstr&, int n, int pos);
-  void xrefForNext(int n, int pos);
+  DslFLInfo xrefForNext(cstdstr&, int n, int pos);
+  DslFLInfo xrefForNext(int n, int pos);
+  int resolve(int line, bool sub, d::Addr);
   void addForLoop(DslFLInfo);
 
   //void addr(d::Addr m) { curMark=m; }
   //d::Addr addr() { return curMark;}
 
-  Basic(const Tchar* src) : source(src){}
+  // src[0,len) is read in place, it needn't end in a nul.
+  Basic(const Tchar* src, int len, int opts=0) : source(src), length(len), options(opts){}
   d::DValue interpret();
-  virtual ~Basic(){}
+  virtual ~Basic();
 
   private:
 
-  std::map<stdstr,DslFLInfo> forBegins;
-  std::map<stdstr,DslFLInfo> forEnds;
-
   std::stack<CheckPt> gosubReturns;
-  std::map<int,int> lines;
+  LineIndex lines;
 
   std::map<stdstr,d::DValue> defs;
 
-  d::ValVec dataSlots;
+  std::map<stdstr,int> slotIds;
+  StrVec slotNames;
+  ValueVec slots;
+
+  ValueVec dataSlots;
   int dataPtr=0;
   //d::Addr curMark;
 
   const Tchar* source;
+  int length;
+  Chunk* code=P_NIL;
+  int options;
   DslFLInfo forLoop;
   bool running=0;
   int progCounter=0;
@@ -287,32 +641,58 @@ struct Basic : public d::IEvaluator, public d::IAnalyzer{
   d::DFrame stack;
   d::DTable symbols;
   void init_lambdas();
+  void init_slots();
   void check(d::DAst);
   d::DFrame root_env();
   d::DValue eval(d::DAst);
+  d::DValue exec(d::DAst);
 };
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 d::DValue expected(cstdstr&, d::DValue, d::Addr);
 d::DValue expected(cstdstr&, d::DValue);
-d::DValue op_math(d::DValue, int op, d::DValue);
-void ensure_data_type(cstdstr&, d::DValue);
+const Value& expected_num(const Value&, d::Addr);
+Value op_math(const Value&, int op, const Value&);
+Value op_binary(const Value&, int op, const Value&, d::Addr);
+Value op_relation(const Value&, int op, const Value&, d::Addr);
+Value op_relnum(const Value&, int op, const Value&);
+void ensure_data_type(cstdstr&, const Value&);
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template <typename T> struct Kind;
+template <> struct Kind<d::Number>{ static const int value= K_NUMBER; };
+template <> struct Kind<d::String>{ static const int value= K_STRING; };
+template <> struct Kind<BArray>{ static const int value= K_ARRAY; };
+template <> struct Kind<LibFunc>{ static const int value= K_LIBFUNC; };
+template <> struct Kind<Lambda>{ static const int value= K_LAMBDA; };
+template <> struct Kind<BChar>{ static const int value= K_CHAR; };
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int kind_of(const d::Data*);
+
+// a dsl number or string, anything else in a value is an Object.
+inline bool is_dsl(const d::Data* p){
+  auto& t= typeid(*p);
+  return t == typeid(d::Number) || t == typeid(d::String);
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 template <typename T>
 T* vcast(d::DValue v){
-  T obj;
-  if(auto p= v.get(); p &&
-     typeid(obj)==typeid(*p))
-    return s__cast(T,p); else return P_NIL;
+  auto p= v.get();
+  if constexpr(std::is_base_of<Object,T>::value){
+    return p && !is_dsl(p) &&
+           s__cast(Object,p)->kind() == Kind<T>::value ? s__cast(T,p) : P_NIL;
+  }else{
+    return p && typeid(*p) == typeid(T) ? s__cast(T,p) : P_NIL; }
 }
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 template <typename T>
 T* vcast(d::DValue v, d::Addr mark){
+  if(auto p= vcast<T>(v); p){ return p; }
+  // only for the error message.
   T obj;
-  if(auto p= v.get(); p &&
-     typeid(obj)==typeid(*p)) return s__cast(T,p);
   if(_1(mark) == 0 &&
      _2(mark) == 0)
     expected(obj.rtti(), v);
@@ -321,6 +701,26 @@ T* vcast(d::DValue v, d::Addr mark){
   return P_NIL;
 }
 
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+// numbers are never boxed in a Value, test the tag instead.
+template <typename T>
+T* vcast(const Value& v){
+  static_assert(!std::is_same<T,d::Number>::value);
+  return v.kind == Kind<T>::value ? s__cast(T,v.obj().get()) : P_NIL;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+template <typename T>
+T* vcast(const Value& v, d::Addr mark){
+  static_assert(!std::is_same<T,d::Number>::value);
+  if(auto p= vcast<T>(v); p){ return p; }
+  return vcast<T>(v.box(), mark);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+inline const Value& vnum(const Value& v, d::Addr mark){
+  return v.isNum() ? v : expected_num(v, mark);
+}
 
 //;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
 }
@@ -0,0 +1,710 @@
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "vm.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace a= czlab::aeon;
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static StrVec OPNAMES {
+  "HALT", "NOP", "CONST", "LOAD", "STORE", "SET", "POP",
+  "BINOP", "RELOP", "MATH", "RELNUM", "UNARY", "NOT", "TRUTH", "NUM", "BOOL",
+  "JMP", "JMPF", "JMPT", "GOTO", "GOTOX", "GOSUB", "GOSUBX",
+  "RETURN", "ON", "CALL", "ASTORE", "FORINIT", "FORNEXT",
+  "PRINT", "PRINTLN", "INPUT", "READ", "AREAD", "RESTORE", "DIM", "SDIM", "MAT", "END"
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+stdstr Chunk::pr_str() const{
+  stdstr buf;
+  for(int i=0,e=code.size(); i<e; ++i){
+    auto& x= code[i];
+    buf += N_STR(i) + "\t" + OPNAMES[x.op] +
+           " " + N_STR(x.a) + " " + N_STR(x.b) + "\n"; }
+  return buf;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+Chunk* Compiler::compile(d::DAst tree){
+  out= new Chunk();
+  DCAST(Ast,tree)->compile(this);
+  link();
+  return out;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Compiler::emit(int op, int a, int b){
+  Instr i {op,a,b};
+  s__conj(out->code, i);
+  s__conj(out->marks, curMark);
+  return here()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Compiler::patch(int at, int a){ out->code[at].a= a; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Compiler::patch2(int at, int b){ out->code[at].b= b; }
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Compiler::konst(const Value& v){
+  s__conj(out->consts, v);
+  return (int) out->consts.size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Compiler::table(const IntVec& targets){
+  std::vector<CheckPt> t;
+  for(auto n : targets)
+    s__conj(t, s__pair(int,int,n,-1));
+  s__conj(out->tables, t);
+  return (int) out->tables.size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int Compiler::loop(int slot){
+  s__conj(out->loops, slot);
+  return (int) out->loops.size()-1;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Compiler::line(int pos, int line){
+  ASSERT1(pos == (int) out->starts.size());
+  s__conj(out->starts, here());
+  lineAddrs[line]= here();
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Compiler::jump(int op, int line){
+  // backward targets are known now, forward ones get linked later.
+  auto it= lineAddrs.find(line);
+  emit(op, it == lineAddrs.end() ? -1 : _2_(it), line);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+LoopCtx Compiler::popLoop(){
+  // must!
+  ASSERT1(!loops.empty());
+  auto c= loops.back();
+  loops.pop_back();
+  return c;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Compiler::link(){
+  // constant targets were checked during analysis,
+  // so every line here has an address.
+  for(auto& x : out->code){
+    if((x.op == OP_GOTO ||
+        x.op == OP_GOSUB) && x.a < 0)
+      if(auto i= lineAddrs.find(x.b);
+         i != lineAddrs.end()) { x.a= _2_(i); } }
+
+  for(auto& t : out->tables)
+    for(auto& x : t)
+      if(auto i= lineAddrs.find(_1(x));
+         i != lineAddrs.end()) { x.second= _2_(i); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Program::compile(Compiler* c){
+  for(int i=0,e=vlines.size(); i<e; ++i){
+    c->line(i, DCAST(Compound,vlines[i])->line());
+    DCAST(Ast,vlines[i])->compile(c); }
+  c->emit(OP_HALT);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Compound::compile(Compiler* c){
+  for(auto& s : stmts)
+    DCAST(Ast,s)->compile(c);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void OnXXX::compile(Compiler* c){
+  DCAST(Ast,var)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(OP_ON, c->table(targets), tok()->type());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void ForNext::compile(Compiler* c){
+  auto f= c->popLoop();
+  c->mark(tok()->addr());
+  c->emit(OP_FORNEXT, f.loop, f.body);
+  c->patch2(f.exit, c->here());
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void ForLoop::compile(Compiler* c){
+  auto n= c->loop(DCAST(Var,var)->slot());
+  DCAST(Ast,term)->compile(c);
+  DCAST(Ast,step)->compile(c);
+  DCAST(Ast,init)->compile(c);
+  c->mark(tok()->addr());
+  auto at= c->emit(OP_FORINIT, n, -1);
+  c->pushLoop(LoopCtx{n, c->here(), at});
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void IfThen::compile(Compiler* c){
+  DCAST(Ast,cond)->compile(c);
+  c->mark(tok()->addr());
+  auto j= c->emit(OP_JMPF);
+  DCAST(Ast,then)->compile(c);
+  if(!elze)
+    c->patch(j, c->here());
+  else{
+    auto k= c->emit(OP_JMP);
+    c->patch(j, c->here());
+    DCAST(Ast,elze)->compile(c);
+    c->patch(k, c->here()); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Run::compile(Compiler*){}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Restore::compile(Compiler* c){
+  c->mark(tok()->addr());
+  c->emit(OP_RESTORE);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void End::compile(Compiler* c){
+  c->mark(tok()->addr());
+  c->emit(OP_END);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Data::compile(Compiler*){
+  // data is collected during analysis.
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void GoSubReturn::compile(Compiler* c){
+  c->mark(tok()->addr());
+  c->emit(OP_RETURN);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void GoSub::compile(Compiler* c){
+  if(auto n= acast<Num>(expr); n &&
+     n->tok()->type() == d::T_INT){
+    c->mark(tok()->addr());
+    c->jump(OP_GOSUB, n->tok()->getInt());
+  }else{
+    DCAST(Ast,expr)->compile(c);
+    c->mark(tok()->addr());
+    c->emit(OP_GOSUBX); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Goto::compile(Compiler* c){
+  if(auto n= acast<Num>(expr); n &&
+     n->tok()->type() == d::T_INT){
+    c->mark(tok()->addr());
+    c->jump(OP_GOTO, n->tok()->getInt());
+  }else{
+    DCAST(Ast,expr)->compile(c);
+    c->mark(tok()->addr());
+    c->emit(OP_GOTOX); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void FuncCall::compile(Compiler* c){
+  auto n= DCAST(Var,fn)->slot();
+  for(auto& a : args)
+    DCAST(Ast,a)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(OP_CALL, n, (int) args.size());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BoolTerm::compile(Compiler* c){
+  if(terms.size() == 1){
+    // passed through, but still has to be a number.
+    DCAST(Ast,terms[0])->compile(c);
+    c->mark(tok()->addr());
+    c->emit(OP_NUM);
+    return; }
+
+  IntVec fails;
+  for(auto& t : terms){
+    DCAST(Ast,t)->compile(c);
+    c->mark(tok()->addr());
+    s__conj(fails, c->emit(OP_JMPF)); }
+
+  c->emit(OP_CONST, c->konst(Value::make(1)));
+  auto j= c->emit(OP_JMP);
+  for(auto f : fails)
+    c->patch(f, c->here());
+  c->emit(OP_CONST, c->konst(Value::make(0)));
+  c->patch(j, c->here());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BoolExpr::compile(Compiler* c){
+  DCAST(Ast,terms[0])->compile(c);
+  if(terms.size() == 1)
+    return;
+
+  IntVec exits;
+  c->mark(tok()->addr());
+  c->emit(OP_TRUTH);
+  for(int i=0,e=ops.size(); i<e; ++i){
+    auto t= ops[i]->type();
+    // OR short circuits the rest of the expression.
+    if(t == T_OR)
+      s__conj(exits, c->emit(OP_JMPT));
+    DCAST(Ast,terms[i+1])->compile(c);
+    c->mark(tok()->addr());
+    c->emit(OP_TRUTH);
+    c->emit(OP_BOOL, t); }
+
+  for(auto x : exits)
+    c->patch(x, c->here());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void RelationOp::compile(Compiler* c){
+  DCAST(Ast,lhs)->compile(c);
+  DCAST(Ast,rhs)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(typed ? OP_RELNUM : OP_RELOP, tok()->type());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Read::compile(Compiler* c){
+  for(auto& v : vars){
+    if(DCAST(Ast,v)->tok()->type() == T_ARRAYINDEX){
+      auto fc= DCAST(FuncCall,v);
+      auto& args= fc->funcArgs();
+      for(auto& x : args)
+        DCAST(Ast,x)->compile(c);
+      c->mark(tok()->addr());
+      c->emit(OP_AREAD,
+              DCAST(Var,fc->funcName())->slot(), (int) args.size());
+    }else{
+      c->mark(tok()->addr());
+      c->emit(OP_READ, DCAST(Var,v)->slot()); } }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void NotFactor::compile(Compiler* c){
+  DCAST(Ast,expr)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(OP_NOT);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void BinOp::compile(Compiler* c){
+  DCAST(Ast,lhs)->compile(c);
+  DCAST(Ast,rhs)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(typed ? OP_MATH : OP_BINOP, tok()->type());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Defun::compile(Compiler*){
+  // lambdas are installed when the program starts.
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Num::compile(Compiler* c){
+  c->emit(OP_CONST, c->konst(num));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void String::compile(Compiler* c){
+  c->emit(OP_CONST, c->konst(str));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Var::compile(Compiler* c){
+  c->emit(OP_LOAD, slot());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void UnaryOp::compile(Compiler* c){
+  DCAST(Ast,expr)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(OP_UNARY, tok()->type());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Print::compile(Compiler* c){
+  auto lastSemi=false;
+  for(auto& i : exprs){
+    auto t= DCAST(Ast,i)->tok()->type();
+    lastSemi=false;
+    if(t == d::T_COMMA){
+      c->emit(OP_CONST, c->konst(Value::make(" ")));
+      c->emit(OP_PRINT);
+    }else
+    if(t == d::T_SEMI)
+      lastSemi=true;
+    else{
+      DCAST(Ast,i)->compile(c);
+      c->emit(OP_PRINT); } }
+
+  if(tok()->type() == T_PRINTLN || !lastSemi)
+    c->emit(OP_PRINTLN);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void PrintSep::compile(Compiler* c){
+  c->emit(OP_CONST, c->konst(Value::make(tok()->type())));
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Assignment::compile(Compiler* c){
+  DCAST(Ast,rhs)->compile(c);
+  if(DCAST(Ast,lhs)->tok()->type() == T_ARRAYINDEX){
+    auto fc= DCAST(FuncCall,lhs);
+    auto& args= fc->funcArgs();
+    for(auto& x : args)
+      DCAST(Ast,x)->compile(c);
+    c->mark(tok()->addr());
+    c->emit(OP_ASTORE,
+            DCAST(Var,fc->funcName())->slot(), (int) args.size());
+  }else{
+    c->mark(tok()->addr());
+    c->emit(typed ? OP_SET : OP_STORE, DCAST(Var,lhs)->slot()); }
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void ArrayDecl::compile(Compiler* c){
+  c->mark(tok()->addr());
+  for(auto& x : sizes)
+    DCAST(Ast,x)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(sparse ? OP_SDIM : OP_DIM,
+          DCAST(Var,var)->slot(), (int) sizes.size());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void MatStmt::compile(Compiler* c){
+  if(lhs) DCAST(Ast,lhs)->compile(c);
+  if(rhs) DCAST(Ast,rhs)->compile(c);
+  c->mark(tok()->addr());
+  c->emit(OP_MAT, DCAST(Var,var)->slot(), op);
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Comment::compile(Compiler*){}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+void Input::compile(Compiler* c){
+  c->mark(tok()->addr());
+  c->emit(OP_INPUT, DCAST(Var,var)->slot());
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static bool for_quit(const Value& s, const Value& t, double z){
+  bool quit=1;
+  if(s.isPos())
+    quit = z > t.getFloat();
+  if(s.isNeg())
+    quit = z < t.getFloat();
+  return quit;
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+static bool for_quit(const Value& s, const Value& t, llong z){
+  bool quit=1;
+  if(s.isPos())
+    quit = z > t.getInt();
+  if(s.isNeg())
+    quit = z < t.getInt();
+  return quit;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+int VM::locate(const Chunk& k, int line, bool sub){
+  auto pos= vm->locate(line);
+  if(pos < 0){
+    if(sub)
+      RAISE(d::BadArg, "Bad gosub<%d>", line);
+    else
+      RAISE(d::BadArg, "Bad goto<%d>", line); }
+  return k.starts[pos];
+}
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+d::DValue VM::run(const Chunk& k){
+  auto yes= Value::make(1);
+  auto no= Value::make(0);
+  auto& code= k.code;
+  ValueVec args;
+  int ip=0;
+
+  stack.clear();
+  returns.clear();
+  loops.clear();
+  loops.resize(k.loops.size());
+  sites.clear();
+  sites.resize(code.size());
+
+  while(vm->isOn()){
+    auto pc= ip++;
+    auto& i= code[pc];
+    switch(i.op){
+    case OP_HALT:
+      vm->halt();
+    break;
+    case OP_NOP:
+    break;
+    case OP_CONST:
+      s__conj(stack, k.consts[i.a]);
+    break;
+    case OP_LOAD:
+      s__conj(stack, vm->getSlot(i.a));
+    break;
+    case OP_STORE:
+      vm->setSlot(i.a, stack.back());
+      stack.pop_back();
+    break;
+    case OP_SET:
+      vm->refSlot(i.a)= stack.back();
+      stack.pop_back();
+    break;
+    case OP_POP:
+      stack.pop_back();
+    break;
+    case OP_BINOP: {
+      auto& l= stack.end()[-2];
+      l= op_binary(l, i.a, stack.back(), k.marks[pc]);
+      stack.pop_back();
+    }
+    break;
+    case OP_RELOP: {
+      auto& l= stack.end()[-2];
+      l= op_relation(l, i.a, stack.back(), k.marks[pc]);
+      stack.pop_back();
+    }
+    break;
+    case OP_MATH: {
+      auto& l= stack.end()[-2];
+      l= op_math(l, i.a, stack.back());
+      stack.pop_back();
+    }
+    break;
+    case OP_RELNUM: {
+      auto& l= stack.end()[-2];
+      l= op_relnum(l, i.a, stack.back());
+      stack.pop_back();
+    }
+    break;
+    case OP_UNARY: {
+      auto& v= stack.back();
+      vnum(v, k.marks[pc]);
+      if(i.a == d::T_MINUS)
+        v= v.isInt() ? Value::make(- v.getInt()) : Value::make(- v.getFloat());
+    }
+    break;
+    case OP_NOT: {
+      auto& v= stack.back();
+      v= vnum(v, k.marks[pc]).isZero() ? yes : no;
+    }
+    break;
+    case OP_TRUTH: {
+      auto& v= stack.back();
+      v= vnum(v, k.marks[pc]).isZero() ? no : yes;
+    }
+    break;
+    case OP_NUM:
+      vnum(stack.back(), k.marks[pc]);
+    break;
+    case OP_BOOL: {
+      auto r= !pop().isZero();
+      auto l= !pop().isZero();
+      auto b= i.a == T_XOR ? (l != r) : (l || r);
+      s__conj(stack, b ? yes : no);
+    }
+    break;
+    case OP_JMP:
+      ip= i.a;
+    break;
+    case OP_JMPF: {
+      auto z= vnum(stack.back(), k.marks[pc]).isZero();
+      stack.pop_back();
+      if(z) ip= i.a;
+    }
+    break;
+    case OP_JMPT:
+      if(!stack.back().isZero()) ip= i.a;
+    break;
+    case OP_GOTO:
+      ip= i.a < 0 ? locate(k, i.b, false) : i.a;
+    break;
+    case OP_GOTOX: {
+      auto v= pop();
+      ip= locate(k, vnum(v, k.marks[pc]).getInt(), false);
+    }
+    break;
+    case OP_GOSUB:
+      s__conj(returns, ip);
+      ip= i.a < 0 ? locate(k, i.b, true) : i.a;
+    break;
+    case OP_GOSUBX: {
+      auto v= pop();
+      s__conj(returns, ip);
+      ip= locate(k, vnum(v, k.marks[pc]).getInt(), true);
+    }
+    break;
+    case OP_RETURN:
+      if(returns.empty())
+        RAISE(d::BadArg, "Bad gosub-return: %s", "no sub called");
+      ip= returns.back();
+      returns.pop_back();
+    break;
+    case OP_ON: {
+      auto v= pop();
+      auto x= vnum(v, k.marks[pc]).getInt();
+      auto& t= k.tables[i.a];
+      //if x is 1, it jumps to the first line in the list;
+      //if x is 2, it jumps to the second line, and so on.
+      if(x > 0 && x <= (int) t.size()){
+        auto& c= t[x-1];
+        auto sub= i.b == T_GOSUB;
+        if(sub)
+          s__conj(returns, ip);
+        ip= _2(c) < 0 ? locate(k, _1(c), sub) : _2(c); }
+    }
+    break;
+    case OP_CALL: {
+      auto& f= vm->getSlot(i.a);
+      ValSlice _args(stack.data()+stack.size()-i.b, stack.data()+stack.size());
+      auto res= sites[pc].call(vm, f, _args, vm->slotName(i.a), k.marks[pc]);
+      stack.resize(stack.size()-i.b);
+      s__conj(stack, res);
+    }
+    break;
+    case OP_ASTORE: {
+      ValSlice _args(stack.data()+stack.size()-i.b, stack.data()+stack.size());
+      auto& res= stack.end()[-i.b-1];
+      auto arr= vcast<BArray>(vm->getSlot(i.a), k.marks[pc]);
+      ensure_data_type(vm->slotName(i.a),res);
+      arr->set(_args, res);
+      stack.resize(stack.size()-i.b-1);
+    }
+    break;
+    case OP_FORINIT: {
+      // TO and STEP are kept for the life of the loop.
+      auto& r= loops[i.a];
+      auto _i= pop();
+      r.step= pop();
+      r.term= pop();
+      auto& _A= k.marks[pc];
+      vnum(r.step,_A);
+      vnum(r.term,_A);
+      auto z= vnum(_i,_A).getFloat();
+      vm->setSlot(k.loops[i.a], _i);
+      r.ints= _i.isInt() && r.term.isInt() && r.step.isInt();
+      if(for_quit(r.step,r.term,z)) ip= i.b;
+    }
+    break;
+    case OP_FORNEXT: {
+      auto& r= loops[i.a];
+      auto n= k.loops[i.a];
+      auto& v= vm->refSlot(n);
+      if(r.ints && v.isInt()){
+        auto x= v.getInt() + r.step.getInt();
+        v= Value::make(x);
+        if(!for_quit(r.step,r.term,x)) ip= i.b;
+      }else{
+        vnum(v,k.marks[pc]);
+        //do var +/- step
+        auto z = v.getFloat() + r.step.getFloat();
+        vm->setSlot(n, v.isInt() ? Value::make((llong) z) : Value::make(z));
+        if(!for_quit(r.step,r.term,z)) ip= i.b; }
+    }
+    break;
+    case OP_PRINT:
+      if(auto v= pop(); v)
+        vm->writeString(v.pr_str(0));
+    break;
+    case OP_PRINTLN:
+      vm->writeln();
+    break;
+    case OP_INPUT: {
+      auto& vn= vm->slotName(i.a);
+      auto res= vm->readString();
+      auto cs= res.c_str();
+      Value v;
+      if(vn[vn.size()-1]=='$')
+        v= Value::make(res);
+      else
+      if(::strchr(cs, '.'))
+        v= Value::make(::atof(cs));
+      else
+        v= Value::make(::atoi(cs));
+      vm->setSlot(i.a,v);
+    }
+    break;
+    case OP_READ: {
+      auto res= vm->readData();
+      if(!res)
+        E_SEMANTIC("Can't read data near %s", d::pr_addr(k.marks[pc]).c_str());
+      vm->setSlot(i.a, res);
+    }
+    break;
+    case OP_AREAD: {
+      ValSlice _args(stack.data()+stack.size()-i.b, stack.data()+stack.size());
+      auto res= vm->readData();
+      if(!res)
+        E_SEMANTIC("Can't read data near %s", d::pr_addr(k.marks[pc]).c_str());
+      auto arr= vcast<BArray>(vm->getSlot(i.a), k.marks[pc]);
+      ensure_data_type(vm->slotName(i.a),res);
+      arr->set(_args, res);
+      stack.resize(stack.size()-i.b);
+    }
+    break;
+    case OP_RESTORE:
+      vm->restore();
+    break;
+    case OP_DIM:
+    case OP_SDIM: {
+      IntVec dims;
+      for(auto j= stack.size()-i.b; j < stack.size(); ++j)
+        s__conj(dims, BArray::dim(stack[j], k.marks[pc]));
+      stack.resize(stack.size()-i.b);
+      vm->refSlot(i.a)=
+        Value::make(BArray::make(dims,
+                                 array_type(vm->slotName(i.a)), i.op == OP_SDIM));
+    }
+    break;
+    case OP_MAT: {
+      auto n= mat_arity(i.b);
+      auto top= stack.size();
+      mat_run(i.b, vm->getSlot(i.a),
+              n > 0 ? stack[top-n] : Value(),
+              n > 1 ? stack[top-1] : Value(), k.marks[pc]);
+      stack.resize(top-n);
+    }
+    break;
+    case OP_END:
+      vm->halt();
+    break;
+    }
+  }
+
+  return DVAL_NIL;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
@@ -0,0 +1,161 @@
+#pragma once
+/* Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Copyright © 2013-2022, Kenneth Leung. All rights reserved. */
+
+#include "parser.h"
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+namespace czlab::basic{
+namespace d= czlab::dsl;
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+enum OpCode{
+  OP_HALT,
+  OP_NOP,
+  OP_CONST,    // a: const
+  OP_LOAD,     // a: slot
+  OP_STORE,    // a: slot
+  OP_SET,      // a: slot, no type check
+  OP_POP,
+  OP_BINOP,    // a: token type
+  OP_RELOP,    // a: token type
+  OP_MATH,     // a: token type, numbers only
+  OP_RELNUM,   // a: token type, numbers only
+  OP_UNARY,    // a: token type
+  OP_NOT,
+  OP_TRUTH,
+  OP_NUM,      // checks for a number, keeps it
+  OP_BOOL,     // a: T_OR or T_XOR
+  OP_JMP,      // a: addr
+  OP_JMPF,     // a: addr, pops
+  OP_JMPT,     // a: addr, keeps
+  OP_GOTO,     // a: addr, b: line
+  OP_GOTOX,
+  OP_GOSUB,    // a: addr, b: line
+  OP_GOSUBX,
+  OP_RETURN,
+  OP_ON,       // a: table, b: T_GOTO or T_GOSUB
+  OP_CALL,     // a: slot, b: argc
+  OP_ASTORE,   // a: slot, b: argc
+  OP_FORINIT,  // a: loop, b: exit addr
+  OP_FORNEXT,  // a: loop, b: body addr
+  OP_PRINT,
+  OP_PRINTLN,
+  OP_INPUT,    // a: slot
+  OP_READ,     // a: slot
+  OP_AREAD,    // a: slot, b: argc
+  OP_RESTORE,
+  OP_DIM,      // a: slot, b: argc
+  OP_SDIM,     // a: slot, b: argc, sparse
+  OP_MAT,      // a: slot, b: op, pops its operands
+  OP_END
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Instr{
+  int op;
+  int a;
+  int b;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Chunk{
+
+  stdstr pr_str() const;
+
+  std::vector<Instr> code;
+  std::vector<d::Addr> marks;
+  std::vector<std::vector<CheckPt>> tables;
+  // loop => counter slot
+  IntVec loops;
+  // program line position => code address
+  IntVec starts;
+  ValueVec consts;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct LoopCtx{
+  int loop, body, exit;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct LoopState{
+  Value term, step;
+  bool ints;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct Compiler{
+
+  Chunk* compile(d::DAst);
+
+  int emit(int op, int a=0, int b=0);
+  void patch(int at, int a);
+  void patch2(int at, int b);
+  int here() const{ return (int) out->code.size(); }
+  void mark(d::Addr m){ curMark=m; }
+
+  int konst(const Value&);
+  int table(const IntVec&);
+  int loop(int slot);
+
+  void line(int pos, int line);
+  void jump(int op, int line);
+
+  void pushLoop(const LoopCtx& c){ s__conj(loops,c); }
+  LoopCtx popLoop();
+
+  Compiler(){ out=P_NIL; }
+  ~Compiler(){}
+
+  private:
+
+  void link();
+
+  Chunk* out;
+  d::Addr curMark;
+  std::vector<LoopCtx> loops;
+  std::map<int,int> lineAddrs;
+};
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+struct VM{
+
+  d::DValue run(const Chunk&);
+
+  VM(Basic* b) : vm(b){}
+  ~VM(){}
+
+  private:
+
+  Value pop(){
+    auto v= stack.back(); stack.pop_back(); return v; }
+
+  int locate(const Chunk&, int line, bool sub);
+
+  ValueVec stack;
+  IntVec returns;
+  std::vector<LoopState> loops;
+  // by code address, only OP_CALL uses them.
+  std::vector<CallSite> sites;
+  Basic* vm;
+};
+
+
+
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+}
+//;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+//EOF
+
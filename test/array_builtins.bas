@@ -0,0 +1,50 @@
+1000 PRINT "### ARRAY BUILTINS ###"
+1010 REM 7 CELLS EACH, 0 TO 6, NOT A MULTIPLE OF 4
+1020 DIM A%(6), B(6), C(6), S(6)
+1030 FOR I=0 TO 6
+1040 A%(I) = I
+1050 B(I) = I*I
+1060 NEXT I
+1100 PRINT "SUM(A%), WANT 21"
+1110 PRINT SUM(A%)
+1120 PRINT "SUM(B), WANT 91"
+1130 PRINT SUM(B)
+1140 PRINT "MIN(A%) AND MAX(A%), WANT 0 6"
+1150 PRINT MIN(A%)
+1160 PRINT MAX(A%)
+1170 PRINT "MIN(B) AND MAX(B), WANT 0 36"
+1180 PRINT MIN(B)
+1190 PRINT MAX(B)
+1200 PRINT "MIN(3,1,2) AND MAX(3,1,2), WANT 1 3"
+1210 PRINT MIN(3,1,2)
+1220 PRINT MAX(3,1,2)
+1230 PRINT "MEAN(A%) AND MEAN(B), WANT 3 13"
+1240 PRINT MEAN(A%)
+1250 PRINT MEAN(B)
+1260 PRINT "DOT(A%,B), WANT 441"
+1270 PRINT DOT(A%,B)
+1300 PRINT "FILL(C,2), WANT 7 14"
+1310 PRINT FILL(C,2)
+1320 PRINT SUM(C)
+1330 PRINT "FILL(A%,5), WANT 7 35"
+1340 PRINT FILL(A%,5)
+1350 PRINT SUM(A%)
+1360 PRINT "COPY(C,B), WANT 7 91 36"
+1370 PRINT COPY(C,B)
+1380 PRINT SUM(C)
+1390 PRINT C(6)
+1400 PRINT "SQR(C,B), WANT 7 21 6, B KEEPS 91"
+1410 PRINT SQR(C,B)
+1420 PRINT SUM(C)
+1430 PRINT C(6)
+1440 PRINT SUM(B)
+1450 PRINT "SQR(B), WANT 7 21"
+1460 PRINT SQR(B)
+1470 PRINT SUM(B)
+1480 PRINT "SIN(S) ON ZEROS, WANT 7 0"
+1490 PRINT SIN(S)
+1500 PRINT SUM(S)
+1510 PRINT "EXP(S) ON ZEROS, WANT 7 7"
+1520 PRINT EXP(S)
+1530 PRINT SUM(S)
+1540 END
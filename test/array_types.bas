@@ -0,0 +1,30 @@
+1000 PRINT "### TYPED ARRAYS ###"
+1010 DIM N$(3), A%(3), B#(3), C!(3), D(3)
+1020 N$(1) = "HELLO"
+1030 N$(2) = N$(1) + " WORLD"
+1040 A%(1) = 7
+1050 B#(1) = 1.5
+1060 C!(1) = 0.25
+1070 D(1) = 3
+1080 D(2) = 3.5
+1090 PRINT "WRITTEN, WANT HELLO, HELLO WORLD"
+1100 PRINT N$(1)
+1110 PRINT N$(2)
+1120 PRINT "WRITTEN, WANT 7 1.5 0.25 3 3.5"
+1130 PRINT A%(1)
+1140 PRINT B#(1)
+1150 PRINT C!(1)
+1160 PRINT D(1)
+1170 PRINT D(2)
+1180 PRINT "UNTOUCHED, WANT [] 0 0 0 0"
+1190 PRINT "[";N$(3);"]"
+1200 PRINT A%(3)
+1210 PRINT B#(3)
+1220 PRINT C!(3)
+1230 PRINT D(3)
+1240 PRINT "REALS IN A % ARRAY ROUND TOWARD ZERO, WANT 2 -2"
+1250 A%(2) = 2.5
+1260 A%(3) = -2.5
+1270 PRINT A%(2)
+1280 PRINT A%(3)
+1290 END
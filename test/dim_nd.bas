@@ -0,0 +1,27 @@
+1000 PRINT "### N-DIMENSION ARRAYS ###"
+1010 N = 3
+1020 DIM A(N*2), Q(2,3,2,1)
+1030 FOR I=0 TO N*2
+1040 A(I) = I*I
+1050 NEXT I
+1060 PRINT "A(N*2) HAS 7 CELLS, WANT 0 36"
+1070 PRINT A(0)
+1080 PRINT A(6)
+1090 FOR I=0 TO 2
+1100 FOR J=0 TO 3
+1110 FOR K=0 TO 2
+1120 FOR L=0 TO 1
+1130 Q(I,J,K,L) = I*1000 + J*100 + K*10 + L
+1140 NEXT L
+1150 NEXT K
+1160 NEXT J
+1170 NEXT I
+1180 PRINT "4-D, WANT 0 1321 2321 2000"
+1190 PRINT Q(0,0,0,0)
+1200 PRINT Q(1,3,2,1)
+1210 PRINT Q(2,3,2,1)
+1220 PRINT Q(2,0,0,0)
+1230 PRINT "Q(1,4,0,0) USED TO READ Q(2,0,0,0), NOW IT STOPS THE RUN"
+1240 PRINT Q(1,4,0,0)
+1250 PRINT "NOT REACHED"
+1260 END
@@ -0,0 +1,63 @@
+1000 PRINT "### MAT STATEMENTS ###"
+1010 DIM B(2,2), C(2,2), P(2,2), D(2,3), E(3,2), K(2,3)
+1020 FOR I=1 TO 2
+1030 FOR J=1 TO 2
+1040 READ B(I,J)
+1050 NEXT J
+1060 NEXT I
+1070 FOR I=1 TO 2
+1080 FOR J=1 TO 2
+1090 READ C(I,J)
+1100 NEXT J
+1110 NEXT I
+1120 FOR I=1 TO 2
+1130 FOR J=1 TO 3
+1140 D(I,J) = I*10 + J
+1150 NEXT J
+1160 NEXT I
+1200 PRINT "B * C, WANT 19 22 43 50"
+1210 MAT P = B * C
+1220 GOSUB 5000
+1230 PRINT "B + C, WANT 6 8 10 12"
+1240 MAT P = B + C
+1250 GOSUB 5000
+1260 PRINT "C - B, WANT 4 4 4 4"
+1270 MAT P = C - B
+1280 GOSUB 5000
+1290 PRINT "(3) * B, WANT 3 6 9 12"
+1300 MAT P = (3) * B
+1310 GOSUB 5000
+1320 PRINT "TRN(B), WANT 1 3 2 4"
+1330 MAT P = TRN(B)
+1340 GOSUB 5000
+1350 PRINT "IDN, WANT 1 0 0 1"
+1360 MAT P = IDN
+1370 GOSUB 5000
+1380 PRINT "CON, WANT 1 1 1 1"
+1390 MAT P = CON
+1400 GOSUB 5000
+1410 PRINT "ZER, WANT 0 0 0 0"
+1420 MAT P = ZER
+1430 GOSUB 5000
+1440 PRINT "TRN(D), WANT 11 21 12 22 13 23"
+1450 MAT E = TRN(D)
+1460 FOR I=1 TO 3
+1470 PRINT E(I,1)
+1480 PRINT E(I,2)
+1490 NEXT I
+1500 PRINT "EACH ERROR STOPS THE RUN"
+1510 PRINT "1 = IDN ON A 2X3 ARRAY, 2 = B + D"
+1520 INPUT X
+1530 IF X = 2 THEN 1560
+1540 MAT K = IDN
+1550 GOTO 1570
+1560 MAT P = B + D
+1570 PRINT "NOT REACHED"
+1580 END
+2000 DATA 1,2,3,4
+2010 DATA 5,6,7,8
+5000 FOR I=1 TO 2
+5010 PRINT P(I,1)
+5020 PRINT P(I,2)
+5030 NEXT I
+5040 RETURN
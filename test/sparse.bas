@@ -0,0 +1,29 @@
+1000 PRINT "### SPARSE ARRAYS ###"
+1010 REM OVER SPARSE_MIN CELLS, SO PAGED WITHOUT ASKING
+1020 DIM A(2000000)
+1030 REM PAGES ARE 4096 CELLS, 4095 AND 4096 SIT ON TWO PAGES
+1040 A(4095) = 1
+1050 A(4096) = 2
+1060 A(2000000) = 3
+1070 PRINT "WRITTEN, WANT 1 2 3"
+1080 PRINT A(4095)
+1090 PRINT A(4096)
+1100 PRINT A(2000000)
+1110 PRINT "UNTOUCHED, WANT 0 0 0"
+1120 PRINT A(0)
+1130 PRINT A(4097)
+1140 PRINT A(1000000)
+1200 REM ASKED FOR, ROWS ARE 101 CELLS SO B(40,55) AND B(40,56) ARE 4095 AND 4096
+1210 DIM SPARSE B(100,100)
+1220 B(40,55) = 4
+1230 B(40,56) = 5
+1240 B(100,100) = 6
+1250 PRINT "WRITTEN, WANT 4 5 6"
+1260 PRINT B(40,55)
+1270 PRINT B(40,56)
+1280 PRINT B(100,100)
+1290 PRINT "UNTOUCHED, WANT 0 0 0"
+1300 PRINT B(0,0)
+1310 PRINT B(40,57)
+1320 PRINT B(99,99)
+1330 END
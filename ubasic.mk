@@ -37,7 +37,7 @@ PreprocessOnlySwitch   :=-E
 ObjectsFileList        :="ubasic.txt"
 PCHCompileFlags        :=
 MakeDirCommand         :=mkdir -p
-LinkOptions            :=  -O0
+LinkOptions            :=  -O0 -pthread
 IncludePath            :=  $(IncludeSwitch). $(IncludeSwitch)$(ProjectPath)/src $(IncludeSwitch). 
 IncludePCH             := 
 RcIncludePath          := 
@@ -52,7 +52,7 @@ LibPath                := $(LibraryPathSwitch). $(LibraryPathSwitch). $(LibraryP
 AR       := /usr/bin/ar rcu
 CXX      := /usr/bin/clang++
 CC       := /usr/bin/clang
-CXXFLAGS := -std=c11 -std=c++20 -Wall -g -Wall $(Preprocessors)
+CXXFLAGS := -std=c11 -std=c++20 -Wall -g -Wall -pthread $(Preprocessors)
 CFLAGS   :=   $(Preprocessors)
 ASFLAGS  := 
 AS       := /usr/bin/as
@@ -62,7 +62,7 @@ AS       := /usr/bin/as
 ## User defined environment variables
 ##
 CodeLiteDir:=/Applications/codelite.app/Contents/SharedSupport/
-Objects0=$(IntermediateDirectory)/src_basic_builtins.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_basic.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_lexer.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_parser.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_main.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_dsl_dsl.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_aeon_aeon.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_aeon_Pool.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_types.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_aeon_test.cpp$(ObjectSuffix) \
+Objects0=$(IntermediateDirectory)/src_basic_builtins.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_basic.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_lexer.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_parser.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_main.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_dsl_dsl.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_aeon_aeon.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_aeon_Pool.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_types.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_aeon_test.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_vm.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_fold.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_jit.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_aot.cpp$(ObjectSuffix) $(IntermediateDirectory)/src_basic_mat.cpp$(ObjectSuffix) \
 	
 
 
@@ -154,6 +154,36 @@ $(IntermediateDirectory)/src_aeon_test.cpp$(ObjectSuffix): src/aeon/test.cpp
 $(IntermediateDirectory)/src_aeon_test.cpp$(PreprocessSuffix): src/aeon/test.cpp
 	$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) $(PreprocessOnlySwitch) $(OutputSwitch) $(IntermediateDirectory)/src_aeon_test.cpp$(PreprocessSuffix) src/aeon/test.cpp
 
+$(IntermediateDirectory)/src_basic_vm.cpp$(ObjectSuffix): src/basic/vm.cpp
+	@$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/src_basic_vm.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/src_basic_vm.cpp$(DependSuffix) -MM src/basic/vm.cpp
+	$(CXX) $(IncludePCH) $(SourceSwitch) "/Users/kenl/wdrive/mygit/lang/ubasic/src/basic/vm.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/src_basic_vm.cpp$(ObjectSuffix) $(IncludePath)
+$(IntermediateDirectory)/src_basic_vm.cpp$(PreprocessSuffix): src/basic/vm.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) $(PreprocessOnlySwitch) $(OutputSwitch) $(IntermediateDirectory)/src_basic_vm.cpp$(PreprocessSuffix) src/basic/vm.cpp
+
+$(IntermediateDirectory)/src_basic_fold.cpp$(ObjectSuffix): src/basic/fold.cpp
+	@$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/src_basic_fold.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/src_basic_fold.cpp$(DependSuffix) -MM src/basic/fold.cpp
+	$(CXX) $(IncludePCH) $(SourceSwitch) "/Users/kenl/wdrive/mygit/lang/ubasic/src/basic/fold.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/src_basic_fold.cpp$(ObjectSuffix) $(IncludePath)
+$(IntermediateDirectory)/src_basic_fold.cpp$(PreprocessSuffix): src/basic/fold.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) $(PreprocessOnlySwitch) $(OutputSwitch) $(IntermediateDirectory)/src_basic_fold.cpp$(PreprocessSuffix) src/basic/fold.cpp
+
+$(IntermediateDirectory)/src_basic_jit.cpp$(ObjectSuffix): src/basic/jit.cpp
+	@$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/src_basic_jit.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/src_basic_jit.cpp$(DependSuffix) -MM src/basic/jit.cpp
+	$(CXX) $(IncludePCH) $(SourceSwitch) "/Users/kenl/wdrive/mygit/lang/ubasic/src/basic/jit.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/src_basic_jit.cpp$(ObjectSuffix) $(IncludePath)
+$(IntermediateDirectory)/src_basic_jit.cpp$(PreprocessSuffix): src/basic/jit.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) $(PreprocessOnlySwitch) $(OutputSwitch) $(IntermediateDirectory)/src_basic_jit.cpp$(PreprocessSuffix) src/basic/jit.cpp
+
+$(IntermediateDirectory)/src_basic_aot.cpp$(ObjectSuffix): src/basic/aot.cpp
+	@$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/src_basic_aot.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/src_basic_aot.cpp$(DependSuffix) -MM src/basic/aot.cpp
+	$(CXX) $(IncludePCH) $(SourceSwitch) "/Users/kenl/wdrive/mygit/lang/ubasic/src/basic/aot.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/src_basic_aot.cpp$(ObjectSuffix) $(IncludePath)
+$(IntermediateDirectory)/src_basic_aot.cpp$(PreprocessSuffix): src/basic/aot.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) $(PreprocessOnlySwitch) $(OutputSwitch) $(IntermediateDirectory)/src_basic_aot.cpp$(PreprocessSuffix) src/basic/aot.cpp
+
+$(IntermediateDirectory)/src_basic_mat.cpp$(ObjectSuffix): src/basic/mat.cpp
+	@$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) -MG -MP -MT$(IntermediateDirectory)/src_basic_mat.cpp$(ObjectSuffix) -MF$(IntermediateDirectory)/src_basic_mat.cpp$(DependSuffix) -MM src/basic/mat.cpp
+	$(CXX) $(IncludePCH) $(SourceSwitch) "/Users/kenl/wdrive/mygit/lang/ubasic/src/basic/mat.cpp" $(CXXFLAGS) $(ObjectSwitch)$(IntermediateDirectory)/src_basic_mat.cpp$(ObjectSuffix) $(IncludePath)
+$(IntermediateDirectory)/src_basic_mat.cpp$(PreprocessSuffix): src/basic/mat.cpp
+	$(CXX) $(CXXFLAGS) $(IncludePCH) $(IncludePath) $(PreprocessOnlySwitch) $(OutputSwitch) $(IntermediateDirectory)/src_basic_mat.cpp$(PreprocessSuffix) src/basic/mat.cpp
+
 
 -include $(IntermediateDirectory)/*$(DependSuffix)
 ##